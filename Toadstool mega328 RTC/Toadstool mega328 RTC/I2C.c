@@ -14,23 +14,19 @@
 /**
 * @brief	Initialise the TWI
 *
-* @details	This routine initialises the TWI by: calculating Bit-rate, setting pre-scaler & bit-rate
+* @details	This routine initialises the TWI by setting pre-scaler & bit-rate.
+*			These are calculated at compile time from F_CPU and I2C_SCL_HZ (see I2C.h).
+*			The speed actually achieved is I2C_SCL_ACTUAL_HZ.
 *
-* @param[in]	I2C_kHz	The I2C bus speed in kHz (eg. 100 = 100kHz)
-* 
 * @return	none
 ************************************************************************/
-void I2C_init(uint8_t I2C_kHz)
+void I2C_init(void)
 {
-	uint8_t bitRate;
-	volatile uint16_t I2C_Hz = (unsigned long)I2C_kHz * 1000UL;
-	
-	bitRate = (F_CPU / (I2C_Hz * 2 * I2C_PRESCALER)) - (16 / (2 * I2C_PRESCALER) );	//Calculate bit-rate
 	
 	TWSR &= ~((1<<TWPS0)|(1<<TWPS1));		//Clear the pre-scaler
 	TWSR |= I2C_PRESCALER_BIT;				//Set the new pre-scaler
 	
-	TWBR = bitRate;	//Set the bit rate
+	TWBR = I2C_TWBR_VALUE;	//Set the bit rate
 	
 }
 
@@ -203,3 +199,132 @@ void I2C_waitComplete(void)
 	
 }
 
+
+
+/**
+* @brief	Write a buffer to a device in a single transaction
+*
+* @details	Sends START, the device address with WRITE, the prefix bytes (eg. the memory or register
+*			address) and then streams all data bytes, before sending STOP.
+*
+* @param[in]	deviceAddress	The I2C address of the device
+* @param[in]	prefix			Bytes to send before the data (may be NULL if prefixLength is 0)
+* @param[in]	prefixLength	The number of prefix bytes
+* @param[in]	data			The bytes to write
+* @param[in]	dataLength		The number of data bytes
+*
+* @return	1 = Success; 0 = A byte was not acknowledged
+************************************************************************/
+uint8_t I2C_writeBuffer(uint8_t deviceAddress, const uint8_t *prefix, uint8_t prefixLength, const uint8_t *data, uint16_t dataLength)
+{
+	uint8_t isAck;
+	
+	I2C_sendStart();
+	
+	//Send the device Address with WRITE - not ACKed if device not present or busy
+	isAck = (I2C_send(deviceAddress|TW_WRITE) == TW_MT_SLA_ACK);
+	
+	//Send the prefix
+	while (isAck && (prefixLength > 0))
+	{
+		isAck = (I2C_send(*prefix++) == TW_MT_DATA_ACK);
+		prefixLength--;
+	}
+	
+	//Stream the data
+	while (isAck && (dataLength > 0))
+	{
+		isAck = (I2C_send(*data++) == TW_MT_DATA_ACK);
+		dataLength--;
+	}
+	
+	I2C_sendStop();
+	
+	return isAck;
+}
+
+
+
+/**
+* @brief	Read a buffer from a device in a single transaction
+*
+* @details	Sends START, the device address with WRITE and the prefix bytes (eg. the memory or register
+*			address), then a repeated START and the device address with READ.  The data bytes are then
+*			streamed, sending ACK for all but the last byte, before sending STOP.
+*			If prefixLength is 0 the write phase is skipped, and the device's current address is read.
+*
+* @param[in]	deviceAddress	The I2C address of the device
+* @param[in]	prefix			Bytes to send before reading (may be NULL if prefixLength is 0)
+* @param[in]	prefixLength	The number of prefix bytes
+* @param[out]	data			Buffer for the bytes read
+* @param[in]	dataLength		The number of bytes to read
+*
+* @return	1 = Success; 0 = A byte was not acknowledged
+************************************************************************/
+uint8_t I2C_readBuffer(uint8_t deviceAddress, const uint8_t *prefix, uint8_t prefixLength, uint8_t *data, uint16_t dataLength)
+{
+	uint8_t isAck = 1;
+	
+	I2C_sendStart();
+	
+	if (prefixLength > 0)
+	{
+		//Send the device Address with WRITE - we need to write in order to specify the address to read from
+		isAck = (I2C_send(deviceAddress|TW_WRITE) == TW_MT_SLA_ACK);
+		
+		while (isAck && (prefixLength > 0))
+		{
+			isAck = (I2C_send(*prefix++) == TW_MT_DATA_ACK);
+			prefixLength--;
+		}
+		
+		I2C_sendStart();	//Send RESTART Condition - now we read from the address
+	}
+	
+	//Send the device Address with READ
+	if (isAck)
+	{
+		isAck = (I2C_send(deviceAddress|TW_READ) == TW_MR_SLA_ACK);
+	}
+	
+	//Stream the data, sending ACK for every byte except the last (No ACK means we're done reading)
+	while (isAck && (dataLength > 0))
+	{
+		dataLength--;
+		*data++ = I2C_read(dataLength > 0);
+	}
+	
+	I2C_sendStop();
+	
+	return isAck;
+}
+
+
+
+/**
+* @brief	Poll a device until it acknowledges its address
+*
+* @details	Sends START and the device address with WRITE.  If the device does not ACK, a repeated START
+*			and the address are sent again, until the device ACKs or maxPolls attempts have been made.
+*			A STOP is then sent.  Used to detect the end of an EEPROM's internal write cycle.
+*
+* @param[in]	deviceAddress	The I2C address of the device
+* @param[in]	maxPolls		The maximum number of times to send the address (1 or more)
+*
+* @return	1 = Device acknowledged; 0 = Timed out
+************************************************************************/
+uint8_t I2C_pollAck(uint8_t deviceAddress, uint16_t maxPolls)
+{
+	uint8_t isAck;
+	
+	do
+	{
+		I2C_sendStart();	//START, or repeated START if the device did not ACK last time
+		isAck = (I2C_send(deviceAddress|TW_WRITE) == TW_MT_SLA_ACK);
+		maxPolls--;
+	} while (!isAck && (maxPolls > 0));
+	
+	I2C_sendStop();
+	
+	return isAck;
+}
@@ -21,21 +21,49 @@
 #error "F_CPU not defined"
 #endif
 
-#if F_CPU > 4000000UL
-#define I2C_PRESCALER 4					//Value of prescaler for calculation of bitrate
-#define I2C_PRESCALER_BIT (1<<TWPS0)	//Prescaler Bits to be set in TWSR register
-#else
+#ifndef I2C_SCL_HZ
+#define I2C_SCL_HZ 400000UL		//I2C bus speed in Hz.  Can be overridden in toolchain Symbols, eg. "I2C_SCL_HZ=100000UL"
+#endif
+
+//SCL = F_CPU / (16 + 2 * TWBR * Prescaler)
+//Bit-rate and prescaler are calculated at compile time.  The smallest prescaler that allows TWBR to fit in
+//8 bits is chosen, and TWBR is rounded up so the bus never runs faster than requested.
+#define I2C_DIVIDER ((F_CPU + I2C_SCL_HZ - 1) / I2C_SCL_HZ)	//Total number of CPU cycles per SCL cycle
+#define I2C_TWBR_FOR(prescaler) ((I2C_DIVIDER - 16 + (2 * (prescaler)) - 1) / (2 * (prescaler)))
+
+#if I2C_SCL_HZ > 400000UL
+#error "I2C_SCL_HZ above 400kHz (Fast-mode) is not supported by the TWI"
+#elif I2C_DIVIDER < 16
+#error "I2C_SCL_HZ is too fast for F_CPU - SCL can be at most F_CPU/16"
+#elif I2C_TWBR_FOR(1) <= 255
 #define I2C_PRESCALER 1					//Value of prescaler for calculation of bitrate
 #define I2C_PRESCALER_BIT 0				//Prescaler Bits to be set in TWSR register
+#elif I2C_TWBR_FOR(4) <= 255
+#define I2C_PRESCALER 4
+#define I2C_PRESCALER_BIT (1<<TWPS0)
+#elif I2C_TWBR_FOR(16) <= 255
+#define I2C_PRESCALER 16
+#define I2C_PRESCALER_BIT (1<<TWPS1)
+#elif I2C_TWBR_FOR(64) <= 255
+#define I2C_PRESCALER 64
+#define I2C_PRESCALER_BIT ((1<<TWPS1)|(1<<TWPS0))
+#else
+#error "I2C_SCL_HZ is too slow for F_CPU - cannot be reached with any prescaler"
 #endif
 
+#define I2C_TWBR_VALUE I2C_TWBR_FOR(I2C_PRESCALER)	//Value for the TWBR register
+#define I2C_SCL_ACTUAL_HZ (F_CPU / (16 + (2UL * I2C_TWBR_VALUE * I2C_PRESCALER)))	//Bus speed actually achieved, in Hz
+
 
-void I2C_init(uint8_t I2C_kHz);
+void I2C_init(void);
 uint8_t I2C_sendStart(void);
 void I2C_sendStop(void);
 uint8_t I2C_send(uint8_t Data);
 uint8_t I2C_read(uint8_t sendAck);
 void I2C_waitComplete(void);
+uint8_t I2C_writeBuffer(uint8_t deviceAddress, const uint8_t *prefix, uint8_t prefixLength, const uint8_t *data, uint16_t dataLength);
+uint8_t I2C_readBuffer(uint8_t deviceAddress, const uint8_t *prefix, uint8_t prefixLength, uint8_t *data, uint16_t dataLength);
+uint8_t I2C_pollAck(uint8_t deviceAddress, uint16_t maxPolls);
 
 
 
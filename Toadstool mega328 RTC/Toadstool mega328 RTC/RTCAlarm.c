@@ -0,0 +1,126 @@
+/*
+ * @file	RTCAlarm.c
+ *
+ *  Sleep until an RTC alarm goes off
+ *
+ *  The RTC drives MFP low when an alarm goes off (see RTC_setAlarm).  MFP is connected to PD2, and its
+ *  pin change interrupt (PCINT18) wakes the ATmega328P from Power-down - the deepest sleep, with every
+ *  clock stopped.  INT0 on the same pin can't be used: in Power-down it only wakes on a low level, and
+ *  would keep interrupting until the alarm is cleared.
+ *
+ *  Uses PCINT2, and MFP - so can't be used at the same time as SoftClock.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "RTCAlarm.h"
+
+
+static uint8_t alarmDevice;					//I2C address of the RTC
+static volatile uint8_t isAlarmPending = 0;	//1 = MFP has gone low since the alarm was last cleared
+
+
+
+/**
+* @brief	Start watching MFP for alarms
+*
+* @details	Sets PD2 as an input with pull-up (MFP is open-drain), and enables its pin change interrupt.
+*			Set the alarms with RTC_setAlarm.  Enable interrupts after.
+*
+* @param[in]	deviceAddress	The I2C address of the RTC device
+*
+* @return	none
+************************************************************************/
+void RTCAlarm_init(uint8_t deviceAddress)
+{
+	alarmDevice = deviceAddress;
+	
+	DDRD &= ~(1<<PD2);
+	PORTD |= (1<<PD2);
+	
+	EIMSK &= ~(1<<INT0);		//In case SoftClock was using the pin
+	PCMSK2 |= (1<<PCINT18);		//Interrupt on changes of PD2
+	PCIFR = (1<<PCIF2);			//Clear any old change
+	PCICR |= (1<<PCIE2);		//Enable pin change interrupts on PORTD
+}
+
+
+
+/**
+* @brief	Sleep in Power-down until an alarm goes off
+*
+* @details	Returns straight away if an alarm has already gone off.  Other interrupts that wake the
+*			CPU are handled, and it goes back to sleep.
+*			Anything being sent on the UART should be finished first (UART_flush).
+*
+* @return	none
+************************************************************************/
+void RTCAlarm_sleep(void)
+{
+	set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+	
+	cli();
+	
+	while (!isAlarmPending && (PIND & (1<<PD2)))	//MFP is low while an alarm is waiting to be cleared
+	{
+		sleep_enable();
+		sei();
+		sleep_cpu();	//Executed before any interrupt waiting, so can't miss the wake-up
+		sleep_disable();
+		cli();
+	}
+	
+	sei();
+}
+
+
+
+/**
+* @brief	Find which alarms have gone off, and clear them
+*
+* @details	Call after waking.  Clearing an alarm releases MFP, and rearms it: an alarm matching part of the
+*			time goes off again at the next match.  To go off at a different time, set it again with
+*			RTC_setAlarm.
+*
+* @return	Bit 0 = Alarm 0 went off; Bit 1 = Alarm 1 went off
+************************************************************************/
+uint8_t RTCAlarm_service(void)
+{
+	uint8_t alarmFlags;
+	
+	isAlarmPending = 0;	//Clear before the flags, so an alarm going off during the read isn't lost
+	
+	alarmFlags = RTC_getAlarmFlags(alarmDevice);
+	
+	if (alarmFlags & (1<<0))
+	{
+		RTC_clearAlarm(alarmDevice, 0);
+	}
+	if (alarmFlags & (1<<1))
+	{
+		RTC_clearAlarm(alarmDevice, 1);
+	}
+	
+	return alarmFlags;
+}
+
+
+
+/**
+* @brief	Interrupt Handler for Pin Change on PORTD
+*
+* @details	Not called from user code.  Called when MFP changes, waking the CPU.
+*
+* @return	none
+************************************************************************/
+ISR(PCINT2_vect)
+{
+	if ((PIND & (1<<PD2)) == 0)
+	{
+		isAlarmPending = 1;	//MFP pulled low: alarm
+	}
+}
@@ -0,0 +1,27 @@
+/*
+ * @file	RTCAlarm.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef RTCALARM_H_
+#define RTCALARM_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "RTC_MCP79400.h"
+
+
+void RTCAlarm_init(uint8_t deviceAddress);
+void RTCAlarm_sleep(void);
+uint8_t RTCAlarm_service(void);
+
+
+
+#endif /* RTCALARM_H_ */
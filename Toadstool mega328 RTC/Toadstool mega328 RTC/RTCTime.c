@@ -0,0 +1,185 @@
+/*
+ * @file	RTCTime.c
+ *
+ *  Convert RTC times to and from seconds since 2000, and add and subtract them
+ *
+ *  The AVR has no divide instruction: a 32-bit division is a library call of about 600 cycles, and a 16-bit
+ *  one about 200.  So the conversions avoid 32-bit division entirely, and use as few 16-bit ones as they can.
+ *  Measure them with RTC_DEMO_BENCHMARK in the demo application.
+ *
+ *  Years are 2000-2099, as in the RTC, so every 4th year is a leap year.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "RTCTime.h"
+
+
+//Days in the year before the first of each month (not a leap year)
+static const uint16_t daysBeforeMonth[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+
+
+/**
+* @brief	Convert a date and time to an epoch
+*
+* @details	Takes the hour in the format set in RTC_Init, as returned by RTC_GetTime.
+*
+* @param[in]	dateTime	The date and time
+*
+* @return	Seconds since 01/01/2000 00:00:00
+************************************************************************/
+uint32_t RTCTime_toEpoch(const RTC_DateTime *dateTime)
+{
+	uint8_t year = dateTime->year;
+	uint8_t hour = dateTime->hour;
+	uint16_t days;
+	
+	if (!setting24Hour)	//If 12-hour format: 12AM is 0, 12PM is 12
+	{
+		if (hour == 12)
+		{
+			hour = 0;
+		}
+		if (dateTime->isPM)
+		{
+			hour += 12;
+		}
+	}
+	
+	//Days since the epoch.  Each year before this one had a leap day if it was a multiple of 4, starting with 2000
+	days = (uint16_t)year * 365 + ((year + 3) >> 2) + daysBeforeMonth[dateTime->month - 1] + dateTime->day - 1;
+	if (((year & 3) == 0) && (dateTime->month > 2))
+	{
+		days++;	//This year's leap day has passed
+	}
+	
+	return ((uint32_t)days * 1440 + (uint16_t)hour * 60 + dateTime->minute) * 60 + dateTime->second;
+}
+
+
+
+/**
+* @brief	Convert an epoch to a date and time
+*
+* @details	Fills in every field, including the day of the week.  The hour is in the format set in RTC_Init, so
+*			the result can be passed to RTC_SetTime.
+*
+* @param[in]	epoch		Seconds since 01/01/2000 00:00:00
+* @param[out]	dateTime	The date and time
+*
+* @return	none
+************************************************************************/
+void RTCTime_fromEpoch(uint32_t epoch, RTC_DateTime *dateTime)
+{
+	uint16_t days;
+	uint32_t secondOfDay;
+	uint16_t minuteOfDay;
+	uint8_t quad;
+	uint16_t dayOfQuad;
+	uint8_t yearOfQuad;
+	uint8_t isLeapDay = 0;
+	uint8_t month;
+	uint8_t hour;
+	
+	//Days since the epoch, without a 32-bit division.  The top 16 bits of the epoch times 2^32/86400 (49710.27,
+	//rounded down) underestimate the days by at most 2: step up to the right day
+	days = (uint16_t)(((uint32_t)(uint16_t)(epoch >> 16) * 49710UL) >> 16);
+	secondOfDay = epoch - (uint32_t)days * RTCTIME_SECS_PER_DAY;
+	while (secondOfDay >= RTCTIME_SECS_PER_DAY)
+	{
+		days++;
+		secondOfDay -= RTCTIME_SECS_PER_DAY;
+	}
+	
+	//Time of day.  secondOfDay / 4 fits in 16 bits
+	minuteOfDay = (uint16_t)(secondOfDay >> 2) / 15;
+	dateTime->second = (uint8_t)((uint16_t)secondOfDay - minuteOfDay * 60);
+	hour = minuteOfDay / 60;
+	dateTime->minute = (uint8_t)(minuteOfDay - (uint16_t)hour * 60);
+	
+	dateTime->weekDay = ((days + (RTCTIME_EPOCH_WEEKDAY - 1)) % 7) + 1;
+	
+	//Year: whole 4-year blocks, then the year within the block.  The first year of each block has 366 days
+	quad = days / RTCTIME_DAYS_PER_QUAD;
+	dayOfQuad = days - (uint16_t)quad * RTCTIME_DAYS_PER_QUAD;
+	if (dayOfQuad < 366)
+	{
+		yearOfQuad = 0;
+	}
+	else
+	{
+		yearOfQuad = (dayOfQuad < 731) ? 1 : ((dayOfQuad < 1096) ? 2 : 3);
+		dayOfQuad -= 366 + (yearOfQuad - 1) * 365;
+	}
+	dateTime->year = quad * 4 + yearOfQuad;
+	
+	//Month and day.  Take out the leap day, so the table applies
+	if ((yearOfQuad == 0) && (dayOfQuad >= 59))
+	{
+		isLeapDay = (dayOfQuad == 59);	//29th February: counted as the 28th, plus one
+		dayOfQuad--;
+	}
+	month = dayOfQuad >> 5;	//No month is more than 32 days: this is the month, or one before
+	while ((month < 11) && (dayOfQuad >= daysBeforeMonth[month + 1]))
+	{
+		month++;
+	}
+	dateTime->month = month + 1;
+	dateTime->day = (uint8_t)(dayOfQuad - daysBeforeMonth[month]) + 1 + isLeapDay;
+	
+	//Hour, in the format set in RTC_Init
+	dateTime->isPM = 0;
+	if (!setting24Hour)
+	{
+		if (hour >= 12)
+		{
+			dateTime->isPM = 1;
+			hour -= 12;
+		}
+		if (hour == 0)
+		{
+			hour = 12;
+		}
+	}
+	dateTime->hour = hour;
+}
+
+
+
+/**
+* @brief	Add seconds to a date and time
+*
+* @details	The result must stay within 2000-2099.
+*
+* @param[in,out]	dateTime	The date and time to add to
+* @param[in]		seconds		Seconds to add (negative to subtract)
+*
+* @return	none
+************************************************************************/
+void RTCTime_add(RTC_DateTime *dateTime, int32_t seconds)
+{
+	RTCTime_fromEpoch(RTCTime_toEpoch(dateTime) + (uint32_t)seconds, dateTime);
+}
+
+
+
+/**
+* @brief	Find the seconds between two dates and times
+*
+* @details	Can also be used to compare them: positive if later is after earlier.  Times more than 68 years
+*			apart overflow.
+*
+* @param[in]	later		The later date and time
+* @param[in]	earlier		The earlier date and time
+*
+* @return	Seconds from earlier to later
+************************************************************************/
+int32_t RTCTime_diff(const RTC_DateTime *later, const RTC_DateTime *earlier)
+{
+	return (int32_t)(RTCTime_toEpoch(later) - RTCTime_toEpoch(earlier));
+}
@@ -0,0 +1,31 @@
+/*
+ * @file	RTCTime.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef RTCTIME_H_
+#define RTCTIME_H_
+
+#include <avr/io.h>
+#include "RTC_MCP79400.h"
+
+//Epoch: seconds since 01/01/2000 00:00:00 (a Saturday).  The RTC's years (2000-2099) fit in 32 bits
+#define RTCTIME_SECS_PER_DAY	86400UL
+#define RTCTIME_DAYS_PER_QUAD	1461	//Days in 4 years - the RTC's leap years (LPYR) are every 4th, from 2000
+#define RTCTIME_EPOCH_WEEKDAY	7		//Day of the week of 01/01/2000, numbered as in RTC_DateTime
+
+
+uint32_t RTCTime_toEpoch(const RTC_DateTime *dateTime);
+void RTCTime_fromEpoch(uint32_t epoch, RTC_DateTime *dateTime);
+void RTCTime_add(RTC_DateTime *dateTime, int32_t seconds);
+int32_t RTCTime_diff(const RTC_DateTime *later, const RTC_DateTime *earlier);
+
+
+
+#endif /* RTCTIME_H_ */
@@ -16,6 +16,41 @@ volatile uint8_t setting24Hour = 1;		//Do we use 24-hour format?
 
 
 
+/**
+* @brief	Wait for the oscillator to stop or start
+*
+* @details	Polls the OSCRUN bit, up to RTC_OSCRUN_POLLS times.  Gives up straight away if the RTC doesn't
+*			acknowledge, rather than taking the failed read as OSCRUN clear.
+*
+* @param[in]	deviceAddress	The I2C address of the RTC device
+* @param[in]	isRunning		1 = Wait for the oscillator to start; 0 = Wait for it to stop
+*
+* @return	1 = Success; 0 = RTC did not acknowledge, or timed out
+************************************************************************/
+static uint8_t RTC_waitOscillator(uint8_t deviceAddress, uint8_t isRunning)
+{
+	uint8_t registerAddress = MCP794_RTCWKDAY;
+	uint8_t readData;
+	uint16_t pollCount;
+	
+	for (pollCount = 0; pollCount < RTC_OSCRUN_POLLS; pollCount++)
+	{
+		if (!I2C_readBuffer(deviceAddress, &registerAddress, 1, &readData, 1))
+		{
+			return 0;	//Error: RTC did not acknowledge
+		}
+		
+		if (((readData >> MCP794_OSCRUN) & 1) == isRunning)
+		{
+			return 1;
+		}
+	}
+	
+	return 0;
+}
+
+
+
 /**
 * @brief	
 *
@@ -63,11 +98,11 @@ uint8_t RTC_Init(uint8_t deviceAddress, uint8_t is24Hour, uint8_t isBackupBat)
 	tempVar = RTC_read(deviceAddress, MCP794_RTCWKDAY);
 
 	//If Backup Battery setting on module is not same as setting passed, update
-	if ((tempVar & (1<<MCP794_VBATEN)) != isBackupBat)
+	if (((tempVar >> MCP794_VBATEN) & 1) != (isBackupBat ? 1 : 0))
 	{
 		#if DEBUGLEVEL > 2
 		UART_writeString("\r\n---Correcting Backup Battery setting to: ");
-		UART_printDecimal(isBackupBat);
+		UART_printDecimal(isBackupBat,0);
 		UART_writeString("---\r\n");
 		#endif
 
@@ -93,43 +128,60 @@ uint8_t RTC_Init(uint8_t deviceAddress, uint8_t is24Hour, uint8_t isBackupBat)
 		RTC_write(deviceAddress, MCP794_RTCSEC, 10 | (1<<MCP794_ST));	//Reset seconds to 10 (arbitrary) and start oscillator
 	}
 	
-	_delay_ms(10);	//Give oscillator time to start up, then check it's running
-	
 	#if DEBUGLEVEL > 2
 	UART_writeString("\r\n\r\n---Read Osc---\r\n");
 	#endif
 	
-	tempVar = RTC_read(deviceAddress, MCP794_RTCWKDAY);
-	if ( (tempVar & (1<<MCP794_OSCRUN)) == 0)	//Oscillator is not running
+	if (!RTC_waitOscillator(deviceAddress, 1))	//Give oscillator time to start up, checking it's running
 	{
-		
-		#if DEBUGLEVEL > 2
-		UART_writeString("TempVar= ");
-		UART_printDecimal(tempVar,0);
-		UART_writeString("\r\n");
-		#endif
 		return 0;	//Error: Oscillator didn't start
 	}
 	
 	return 1;	//All OK, oscillator started
 }
 
+/**
+* @brief	Encode an hour for the RTCHOUR or ALMxHOUR register
+*
+* @details	The hour is not converted between formats: it must already be in the format chosen in RTC_Init,
+*			as described for RTC_DateTime.
+*
+* @param[in]	hour		Hour: 0-23 in 24-hour format; 1-12 in 12-hour format
+* @param[in]	isHourPM	12-hour format: 1 = PM
+*
+* @return	The register value, in the format chosen in RTC_Init
+************************************************************************/
+static uint8_t RTC_encodeHour(uint8_t hour, uint8_t isHourPM)
+{
+	if (setting24Hour)	//If 24 Hour format:
+	{
+		return decToBcd(hour);
+	}
+	
+	return decToBcd(hour) | (1 << MCP794_12_24) | ((isHourPM ? 1 : 0) << MCP794_AM_PM);	//Include 12/24-hour format
+}
+
+
+
 /**
 * @brief	Set the time on the the RTC
 *
-* @details	This function sets the time
+* @details	This function sets the date and time in a single burst write of the time registers
+*			(RTCSEC to RTCYEAR), including the weekday and the ST and VBATEN bits.
+*			As the datasheet recommends, the oscillator is stopped first and OSCRUN polled until it has
+*			stopped, so the time can't roll over part-way through the write.  OSCRUN is then polled until
+*			the oscillator is running again.
 *
 * @param[in]	deviceAddress	The I2C address of the RTC device
-* @param[in]	setXxxxx		The Value of each Date/Time Element to set
+* @param[in]	dateTime		The date and time to set, with the hour in the format chosen in RTC_Init
 *
-* @return	1 = Success
+* @return	1 = Success; 0 = RTC did not acknowledge, or the oscillator did not stop or restart
 ************************************************************************/
 
-uint8_t RTC_SetTime(uint8_t deviceAddress, uint16_t setYear, uint8_t setMonth, uint8_t setDay, uint8_t setWeekDay, uint8_t setHour, uint8_t isHourPM, uint8_t setMinutes, uint8_t setSeconds)
+uint8_t RTC_SetTime(uint8_t deviceAddress, const RTC_DateTime *dateTime)
 {
-	uint8_t result;
-	uint8_t returnResult = 0;
-	uint8_t sendData = 0;
+	uint8_t registerAddress = MCP794_RTCSEC;
+	uint8_t sendData[MCP794_TIME_REGISTERS];
 	
 #if DEBUGLEVEL > 1
 	UART_writeString("\r\n\r\n--------RTC_SetTime-------\r\n");
@@ -140,103 +192,32 @@ uint8_t RTC_SetTime(uint8_t deviceAddress, uint16_t setYear, uint8_t setMonth, u
 	UART_writeString("---Disable Osc---\r\n");
 #endif
 
-	//Disable Oscillator
-	RTC_write(deviceAddress, MCP794_RTCSEC, 0);  //This also results in seconds going to zero - does not matter as we set them later
-	
-	//Send START Condition
-	result = I2C_sendStart();
-
-
-#if DEBUGLEVEL > 2
-	UART_writeString("---Year---\r\n");
-#endif
-	//---Year
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCYEAR);			//Register
-	//Only interested in last 2 digits of year:
-	if (setYear > 99)
+	//Disable Oscillator, and wait for it to stop
+	if (!RTC_write(deviceAddress, MCP794_RTCSEC, 0) || !RTC_waitOscillator(deviceAddress, 0))
 	{
-		sendData = setYear % 100;
+		return 0;
 	}
-	else
-	{
-		sendData = setYear;
-	}
-	result = I2C_send(decToBcd(sendData));
-
-
-#if DEBUGLEVEL > 2
-	UART_writeString("---Month---\r\n");
-#endif
-	//---Month
-	result = I2C_sendStart();
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCMTH);			//Register
-	result = I2C_send(decToBcd(setMonth));		//Value
 
+	sendData[MCP794_RTCSEC] = decToBcd(dateTime->second) | (1<<MCP794_ST);	//Also start oscillator
+	sendData[MCP794_RTCMIN] = decToBcd(dateTime->minute);
+	sendData[MCP794_RTCHOUR] = RTC_encodeHour(dateTime->hour, dateTime->isPM);
+	
+	sendData[MCP794_RTCWKDAY] = (dateTime->weekDay & MCP794_MASK_WeekDay) | ((settingBackupBat ? 1 : 0) << MCP794_VBATEN);
+	sendData[MCP794_RTCDATE] = decToBcd(dateTime->day);
+	sendData[MCP794_RTCMTH] = decToBcd(dateTime->month);
+	sendData[MCP794_RTCYEAR] = decToBcd(dateTime->year % 100);	//Only the last 2 digits of the year
 
 #if DEBUGLEVEL > 2
-	UART_writeString("---Date---\r\n");
+	UART_writeString("---Write Time---\r\n");
 #endif
-	//---Date
-	result = I2C_sendStart();
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCDATE);			//Register
-	result = I2C_send(decToBcd(setDay));		//Value
-
 
-#if DEBUGLEVEL > 2
-	UART_writeString("---Hour---\r\n");
-#endif
-	//---Hour
-	result = I2C_sendStart();
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCHOUR);			//Register
-	if (setting24Hour)	//If 24 Hour format:
+	//Write the Register Address followed by all the time registers, in one transaction
+	if (!I2C_writeBuffer(deviceAddress, &registerAddress, 1, sendData, MCP794_TIME_REGISTERS))
 	{
-		result = I2C_send(decToBcd(setHour));		//Value - include 12/24-hour format
+		return 0;
 	}
-	else  //12-hour format
-	{
-		if (setHour > 12)	//Check the passed hour is actually 12-hr format
-		{
-			sendData = setHour - 12;
-		}
-		result = I2C_send(decToBcd(sendData) | (1 << MCP794_12_24) | (isHourPM << MCP794_AM_PM));		//Value - include 12/24-hour format
-	}
-	
 
-#if DEBUGLEVEL > 2
-	UART_writeString("---Minute---\r\n");
-#endif
-	
-	//---Minutes
-	result = I2C_sendStart();
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCMIN);			//Register
-	result = I2C_send(decToBcd(setMinutes));		//Value
-	
-
-#if DEBUGLEVEL > 2
-	UART_writeString("---Second---\r\n");
-#endif
-	//---Seconds
-	result = I2C_sendStart();
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCSEC);			//Register
-	result = I2C_send(decToBcd(setSeconds) | (1<<MCP794_ST));		//Value - Also start oscillator
-
-
-#if DEBUGLEVEL > 2
-	UART_writeString("---SendStop---\r\n");
-#endif
-	//Send STOP Condition
-	I2C_sendStop();
-
-	_delay_ms(100);	//Wait for oscilator to start
-
-	returnResult = result;
-	return returnResult;
+	return RTC_waitOscillator(deviceAddress, 1);	//Wait for oscillator to start
 }
 
 
@@ -244,125 +225,53 @@ uint8_t RTC_SetTime(uint8_t deviceAddress, uint16_t setYear, uint8_t setMonth, u
 /**
 * @brief	Read the time on the the RTC
 *
-* @details	This function reads the time
+* @details	This function reads the date and time in a single burst read of the time registers
+*			(RTCSEC to RTCYEAR).  The RTC copies the time registers into a buffer at the start of the
+*			read, so the result is consistent even if the seconds roll over during it.
 *
 * @param[in]	deviceAddress	The I2C address of the RTC device
-* @param[in]	getXxxxx		Pointer to each Date/Time Element to retrieve
+* @param[out]	dateTime		The date and time read
 *
-* @return	1 = Success
+* @return	1 = Success; 0 = RTC did not acknowledge
 ************************************************************************/
 
-uint8_t RTC_GetTime(uint8_t deviceAddress, uint16_t *getYear, uint8_t *getMonth, uint8_t *getDay, uint8_t *getWeekDay, uint8_t *getHour, uint8_t *isHourPM, uint8_t *getMinutes, uint8_t *getSeconds)
+uint8_t RTC_GetTime(uint8_t deviceAddress, RTC_DateTime *dateTime)
 {
-	uint8_t result;
-	uint8_t returnResult = 0;
-	uint8_t readData = 0;
-	
-	//We need to retrieve the entire date/time in one read, so as to prevent time roll-overs and errors
+	uint8_t registerAddress = MCP794_RTCSEC;
+	uint8_t readData[MCP794_TIME_REGISTERS];
+	uint8_t hourData;
 	
-	//Send START Condition.
-	result = I2C_sendStart();
-	
-	//---Year
 	#if DEBUGLEVEL > 2
-	UART_writeString("---Year---\r\n");
+	UART_writeString("---Read Time---\r\n");
 	#endif
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCYEAR);			//Register
-	result = I2C_sendStart();					//Restart - now we're going to do a read operation
-	result = I2C_send(deviceAddress|TW_READ);  //Send the device Address with READ
-	readData = I2C_read(0);
-	*getYear = bcdToDec(readData);
 	
-
-
-	//---Month
-	#if DEBUGLEVEL > 2
-	UART_writeString("---Month---\r\n");
-	#endif
-	result = I2C_sendStart();					//Restart - now we're going to do a Write operation
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCMTH);			//Register
-	result = I2C_sendStart();					//Restart - now we're going to do a read operation
-	result = I2C_send(deviceAddress|TW_READ);	//Send the device Address with READ
-	readData = I2C_read(0) & MCP794_MASK_Month;	//Read the data
-	*getMonth = bcdToDec(readData);				//Convert from BCD to Integer
-
-
-	//---Date
-	#if DEBUGLEVEL > 2
-	UART_writeString("---Day---\r\n");
-	#endif
-	result = I2C_sendStart();
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCDATE);			//Register
-	result = I2C_sendStart();					//Restart - now we're going to do a read operation
-	result = I2C_send(deviceAddress|TW_READ);	//Send the device Address with READ
-	readData = I2C_read(0);						//Read the data
-	*getDay = bcdToDec(readData);				//Convert from BCD to Integer
-
-
-	//---Hour
-	#if DEBUGLEVEL > 2
-	UART_writeString("---Hour---\r\n");
-	#endif
-	result = I2C_sendStart();
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCHOUR);			//Register
-	result = I2C_sendStart();					//Restart - now we're going to do a read operation
-	result = I2C_send(deviceAddress|TW_READ);	//Send the device Address with READ
-	readData = I2C_read(0);						//Read the data
-	
-	if (readData & (1<<MCP794_12_24))	//Is 12-hour format
+	//Write the Register Address, then RESTART and read all the time registers, in one transaction
+	if (!I2C_readBuffer(deviceAddress, &registerAddress, 1, readData, MCP794_TIME_REGISTERS))
+	{
+		return 0;
+	}
+	
+	dateTime->second = bcdToDec(readData[MCP794_RTCSEC] & MCP794_MASK_Second);	//Mask out the ST bit
+	dateTime->minute = bcdToDec(readData[MCP794_RTCMIN] & MCP794_MASK_Minute);
+	
+	hourData = readData[MCP794_RTCHOUR];
+	if (hourData & (1<<MCP794_12_24))	//Is 12-hour format
 	{
-		UART_writeString("\r\n12 Hour Masked = ");
-		UART_printDecimal(readData & MCP794_MASK_12Hour,0);
-		UART_writeString("\r\n12 Hour Converted = ");
-		UART_printDecimal(bcdToDec(readData & MCP794_MASK_12Hour),0);
-		UART_writeString("\r\n");
-		*isHourPM = readData & MCP794_AM_PM;	//Mask out the AM/PM
-		*getHour = bcdToDec(readData & MCP794_MASK_12Hour);	//Mask out the 12-hour time
+		dateTime->isPM = (hourData >> MCP794_AM_PM) & 1;	//Mask out the AM/PM
+		dateTime->hour = bcdToDec(hourData & MCP794_MASK_12Hour);	//Mask out the 12-hour time
 	}
 	else
 	{
-		*isHourPM = 0;
-		*getHour = bcdToDec(readData & MCP794_MASK_24Hour);	//Mask out the 24-hour time
+		dateTime->isPM = 0;
+		dateTime->hour = bcdToDec(hourData & MCP794_MASK_24Hour);	//Mask out the 24-hour time
 	}
-
-
-	//---Minutes
-	#if DEBUGLEVEL > 2
-	UART_writeString("---Minutes---\r\n");
-	#endif
-	result = I2C_sendStart();					//Restart - now we're going to do a Write operation
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCMIN);			//Register
-	result = I2C_sendStart();					//Restart - now we're going to do a read operation
-	result = I2C_send(deviceAddress|TW_READ);	//Send the device Address with READ
-	readData = I2C_read(0);						//Read the data
-	*getMinutes = bcdToDec(readData);				//Convert from BCD to Integer
 	
-
-	//---Seconds
-	#if DEBUGLEVEL > 2
-	UART_writeString("---Seconds---\r\n");
-	#endif
-	result = I2C_sendStart();					//Restart - now we're going to do a Write operation
-	result = I2C_send(deviceAddress|TW_WRITE);  //Send the device Address with WRITE
-	result = I2C_send(MCP794_RTCSEC);			//Register
-	result = I2C_sendStart();					//Restart - now we're going to do a read operation
-	result = I2C_send(deviceAddress|TW_READ);	//Send the device Address with READ
-	readData = I2C_read(0);						//Read the data
-	*getSeconds = bcdToDec(readData & MCP794_MASK_Second);			//Convert from BCD to Integer
-
-
-	//Send STOP Condition
-	I2C_sendStop();
-
-	_delay_ms(10);	//Wait for oscilator to start
-
-	returnResult = result;
-	return returnResult;
+	dateTime->weekDay = readData[MCP794_RTCWKDAY] & MCP794_MASK_WeekDay;	//Mask out the OSCRUN, PWRFAIL and VBATEN bits
+	dateTime->day = bcdToDec(readData[MCP794_RTCDATE] & MCP794_MASK_Date);
+	dateTime->month = bcdToDec(readData[MCP794_RTCMTH] & MCP794_MASK_Month);	//Mask out the LPYR bit
+	dateTime->year = bcdToDec(readData[MCP794_RTCYEAR]);
+	
+	return 1;
 }
 
 
@@ -376,32 +285,16 @@ uint8_t RTC_GetTime(uint8_t deviceAddress, uint16_t *getYear, uint8_t *getMonth,
 * @param[in]	registerAddress	The register to write to
 * @pram[in]	data			The byte to be written to the register
 *
-* @return	1 = Success
+* @return	1 = Success; 0 = RTC did not acknowledge
 ************************************************************************/
 
 uint8_t RTC_write(uint8_t deviceAddress, uint8_t registerAddress, uint8_t data)
 {
-	uint8_t result;
 	uint8_t returnResult = 0;
 	
-	//Send START Condition
-	result = I2C_sendStart();
-	
-	//Send the device Address with WRITE
-	result = I2C_send(deviceAddress|TW_WRITE);
-
-	//Send Register Address to write to
-	result = I2C_send(registerAddress);	
-
-	//Write byte to register
-	result = I2C_send(data);	//Data
-
-	//Send STOP Condition
-	I2C_sendStop();
+	//Send the Register Address followed by the data, in one transaction
+	returnResult = I2C_writeBuffer(deviceAddress, &registerAddress, 1, &data, 1);
 
-	_delay_ms(10);
-
-	returnResult = 1;
 	return returnResult;
 }
 
@@ -422,37 +315,147 @@ uint8_t RTC_read(uint8_t deviceAddress, uint8_t registerAddress)
 {
 	
 	uint8_t readData = 0;
-	uint8_t result;
+
+	//Write the Register Address, then RESTART and read the data, in one transaction
+	I2C_readBuffer(deviceAddress, &registerAddress, 1, &readData, 1);
+	
+	return readData;
+	
+}
+
+
+/**
+* @brief	Set an alarm
+*
+* @details	Writes the alarm registers in one burst write, clearing the alarm's flag, and enables the alarm.
+*			The alarm sets its flag (ALMxIF) when the time matches, and drives MFP low until the flag is
+*			cleared (ALMPOL = 0).  Turns off the square wave output, which would otherwise drive MFP.
+*
+* @param[in]	deviceAddress	The I2C address of the RTC device
+* @param[in]	alarm			Alarm to set: 0 or 1
+* @param[in]	match			The time to match.  Only the fields for matchType are used
+* @param[in]	matchType		RTC_ALARM_MATCH_xxx: which fields must match
+*
+* @return	1 = Success; 0 = RTC did not acknowledge
+************************************************************************/
+uint8_t RTC_setAlarm(uint8_t deviceAddress, uint8_t alarm, const RTC_DateTime *match, uint8_t matchType)
+{
+	uint8_t registerAddress = alarm ? MCP794_ALM1SEC : MCP794_ALM0SEC;
+	uint8_t sendData[MCP794_ALARM_REGISTERS];
+	uint8_t controlData;
+	
+	sendData[MCP794_ALMSEC] = decToBcd(match->second);
+	sendData[MCP794_ALMMIN] = decToBcd(match->minute);
+	sendData[MCP794_ALMHOUR] = RTC_encodeHour(match->hour, match->isPM);
+	sendData[MCP794_ALMWKDAY] = (matchType << MCP794_ALMMSK0) | (match->weekDay & MCP794_MASK_WeekDay);	//ALMPOL = 0, ALMxIF = 0
+	sendData[MCP794_ALMDATE] = decToBcd(match->day);
+	sendData[MCP794_ALMMTH] = decToBcd(match->month);
+	
+	if (!I2C_writeBuffer(deviceAddress, &registerAddress, 1, sendData, MCP794_ALARM_REGISTERS))
+	{
+		return 0;
+	}
+	
+	controlData = RTC_read(deviceAddress, MCP794_CONTROL);
+	controlData &= ~(1<<MCP794_SQWEN);
+	controlData |= (1 << (alarm ? MCP794_ALM1EN : MCP794_ALM0EN));
+	
+	return RTC_write(deviceAddress, MCP794_CONTROL, controlData);
+}
 
 
-	//Send START Condition
-	result = I2C_sendStart();
 
-	//Send the device Address with WRITE - we need to write in order to specify the register to read from
-	result = I2C_send(deviceAddress|TW_WRITE);
+/**
+* @brief	Clear an alarm's flag
+*
+* @details	Clear the flag after the alarm goes off, to release MFP.  The alarm stays enabled, so an alarm
+*			that matches part of the time (eg. RTC_ALARM_MATCH_SECONDS) goes off again at the next match.
+*
+* @param[in]	deviceAddress	The I2C address of the RTC device
+* @param[in]	alarm			Alarm to clear: 0 or 1
+*
+* @return	1 = Success; 0 = RTC did not acknowledge
+************************************************************************/
+uint8_t RTC_clearAlarm(uint8_t deviceAddress, uint8_t alarm)
+{
+	uint8_t registerAddress = (alarm ? MCP794_ALM1SEC : MCP794_ALM0SEC) + MCP794_ALMWKDAY;
+	
+	return RTC_write(deviceAddress, registerAddress, RTC_read(deviceAddress, registerAddress) & ~(1<<MCP794_ALMIF));
+}
 
-	//Send Register Address to read from
-	result = I2C_send(registerAddress);	
 
 
-	//Send RESTART Condition - now we read from the memory address
-	result = I2C_sendStart();
+/**
+* @brief	Disable an alarm
+*
+* @param[in]	deviceAddress	The I2C address of the RTC device
+* @param[in]	alarm			Alarm to disable: 0 or 1
+*
+* @return	1 = Success; 0 = RTC did not acknowledge
+************************************************************************/
+uint8_t RTC_disableAlarm(uint8_t deviceAddress, uint8_t alarm)
+{
+	uint8_t controlData = RTC_read(deviceAddress, MCP794_CONTROL);
+	
+	controlData &= ~(1 << (alarm ? MCP794_ALM1EN : MCP794_ALM0EN));
+	
+	return RTC_write(deviceAddress, MCP794_CONTROL, controlData);
+}
 
 
-	//Send the device Address with READ
-	result = I2C_send(deviceAddress|TW_READ);
 
-	//Read the data returned by the RTC
-	readData = I2C_read(0);	//Read Data with NO ACK  (No ACK means we're done reading)
+/**
+* @brief	Read the alarms' flags
+*
+* @param[in]	deviceAddress	The I2C address of the RTC device
+*
+* @return	Bit 0 = Alarm 0 has gone off; Bit 1 = Alarm 1 has gone off
+************************************************************************/
+uint8_t RTC_getAlarmFlags(uint8_t deviceAddress)
+{
+	uint8_t alarmFlags = 0;
+	
+	if (RTC_read(deviceAddress, MCP794_ALM0SEC + MCP794_ALMWKDAY) & (1<<MCP794_ALMIF))
+	{
+		alarmFlags |= (1<<0);
+	}
+	if (RTC_read(deviceAddress, MCP794_ALM1SEC + MCP794_ALMWKDAY) & (1<<MCP794_ALMIF))
+	{
+		alarmFlags |= (1<<1);
+	}
+	
+	return alarmFlags;
+}
+
 
-	//Send STOP Condition
-	I2C_sendStop();
+
+/**
+* @brief	Number of days in a month
+*
+* @details	Every year divisible by 4 is a leap year - correct for 2000-2099, the years the RTC holds.
+*
+* @param[in]	year	Year within the century (0-99: 2000-2099)
+* @param[in]	month	Month (1-12)
+*
+* @return	Number of days in the month (28-31)
+************************************************************************/
+uint8_t RTC_daysInMonth(uint8_t year, uint8_t month)
+{
+	if (month == 2)
+	{
+		return ((year % 4) == 0) ? 29 : 28;
+	}
 	
-	return readData;
+	if ((month == 4) || (month == 6) || (month == 9) || (month == 11))
+	{
+		return 30;
+	}
 	
+	return 31;
 }
 
 
+
 /**
 * @brief	Convert Decimal to Binary-Coded Decimal
 *
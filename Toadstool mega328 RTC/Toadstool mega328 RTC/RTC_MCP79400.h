@@ -34,6 +34,7 @@
 #define MCP794_MINONE2 2
 #define MCP794_MINONE1 1
 #define MCP794_MINONE0 0
+#define MCP794_MASK_Minute 0b01111111
 
 #define MCP794_RTCHOUR (0x02)
 #define MCP794_12_24 6
@@ -54,6 +55,7 @@
 #define MCP794_WKDAY2 2
 #define MCP794_WKDAY1 1
 #define MCP794_WKDAY0 0
+#define MCP794_MASK_WeekDay 0b00000111
 
 #define MCP794_RTCDATE (0x04)
 #define MCP794_DATETEN1 5
@@ -62,6 +64,7 @@
 #define MCP794_DATEONE2 2
 #define MCP794_DATEONE1 1
 #define MCP794_DATEONE0 0
+#define MCP794_MASK_Date 0b00111111
 
 #define MCP794_RTCMTH 0x05
 #define MCP794_LPYR 5
@@ -92,14 +95,68 @@
 #define MCP794_SQWFS1 1
 #define MCP794_SQWFS0 0
 
+#define MCP794_ALM0SEC 0x0A		//Alarm 0 registers: ALM0SEC to ALM0MTH
+#define MCP794_ALM1SEC 0x11		//Alarm 1 registers: ALM1SEC to ALM1MTH
+#define MCP794_ALMSEC 0			//Offset of each alarm register from ALMxSEC
+#define MCP794_ALMMIN 1
+#define MCP794_ALMHOUR 2
+#define MCP794_ALMWKDAY 3
+#define MCP794_ALMDATE 4
+#define MCP794_ALMMTH 5
+#define MCP794_ALMPOL 7			//ALMxWKDAY bits
+#define MCP794_ALMMSK2 6
+#define MCP794_ALMMSK1 5
+#define MCP794_ALMMSK0 4
+#define MCP794_ALMIF 3
+
+//Alarm matches (ALMxMSK2:0)
+#define RTC_ALARM_MATCH_SECONDS	0b000	//Seconds match: once a minute
+#define RTC_ALARM_MATCH_MINUTES	0b001	//Minutes match: once an hour
+#define RTC_ALARM_MATCH_HOURS	0b010	//Hours match: once a day
+#define RTC_ALARM_MATCH_WEEKDAY	0b011	//Day of the week matches: once a week, at midnight
+#define RTC_ALARM_MATCH_DATE	0b100	//Date matches: once a month, at midnight
+#define RTC_ALARM_MATCH_FULL	0b111	//Seconds, minutes, hours, day of the week, date and month all match
+
+#define MCP794_TIME_REGISTERS 7		//Number of time registers, RTCSEC (0x00) to RTCYEAR (0x06)
+#define MCP794_ALARM_REGISTERS 6	//Number of registers for each alarm, ALMxSEC to ALMxMTH
+
+#ifndef RTC_OSCRUN_POLLS
+#define RTC_OSCRUN_POLLS 1000		//Most reads of OSCRUN while waiting for the oscillator to stop or start (about 100us each at 400kHz)
+#endif
+
+
+
+/**
+* Date and time, as read from (or written to) the RTC's time registers
+*/
+typedef struct
+{
+	uint8_t year;		//Year within the century (0-99: 2000-2099)
+	uint8_t month;		//Month (1-12)
+	uint8_t day;		//Day of the month (1-31)
+	uint8_t weekDay;	//Day of the week (1-7: 1 = Sunday).  The RTC only counts 1-7; RTCTime and the demo use Sunday = 1
+	uint8_t hour;		//Hour, in the format set in RTC_Init: 0-23 in 24-hour format; 1-12 (12 = noon or midnight) in 12-hour format
+	uint8_t isPM;		//12-hour format: 1 = PM (12 PM is noon); 0 = AM (12 AM is midnight).  Always 0 in 24-hour format
+	uint8_t minute;		//Minutes (0-59)
+	uint8_t second;		//Seconds (0-59)
+} RTC_DateTime;
+
+
+
+extern volatile uint8_t setting24Hour;	//Hour format set in RTC_Init: 1 = 24-hour
 
 
 //Function Prototypes
 uint8_t RTC_Init(uint8_t deviceAddress, uint8_t is24Hour, uint8_t isBackupBat);
-uint8_t RTC_SetTime(uint8_t deviceAddress, uint16_t setYear, uint8_t setMonth, uint8_t setDay, uint8_t setWeekDay, uint8_t setHour, uint8_t isHourPM, uint8_t setMinutes, uint8_t setSeconds);
-uint8_t RTC_GetTime(uint8_t deviceAddress, uint16_t *getYear, uint8_t *getMonth, uint8_t *getDay, uint8_t *getWeekDay, uint8_t *getHour, uint8_t *isHourPM, uint8_t *getMinutes, uint8_t *getSeconds);
+uint8_t RTC_SetTime(uint8_t deviceAddress, const RTC_DateTime *dateTime);
+uint8_t RTC_GetTime(uint8_t deviceAddress, RTC_DateTime *dateTime);
 uint8_t RTC_write(uint8_t deviceAddress, uint8_t registerAddress, uint8_t data);
 uint8_t RTC_read(uint8_t deviceAddress, uint8_t registerAddress);
+uint8_t RTC_setAlarm(uint8_t deviceAddress, uint8_t alarm, const RTC_DateTime *match, uint8_t matchType);
+uint8_t RTC_clearAlarm(uint8_t deviceAddress, uint8_t alarm);
+uint8_t RTC_disableAlarm(uint8_t deviceAddress, uint8_t alarm);
+uint8_t RTC_getAlarmFlags(uint8_t deviceAddress);
+uint8_t RTC_daysInMonth(uint8_t year, uint8_t month);
 uint8_t decToBcd(uint8_t val);
 uint8_t bcdToDec(uint8_t val);
 
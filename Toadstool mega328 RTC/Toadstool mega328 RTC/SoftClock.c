@@ -0,0 +1,227 @@
+/*
+ * @file	SoftClock.c
+ *
+ *  Clock in RAM, kept in step by the RTC's 1Hz square wave
+ *
+ *  The RTC's MFP pin outputs a 1Hz square wave to INT0 (PD2).  Each edge moves the clock on a second,
+ *  and restarts Timer1 - so Timer1's count gives the milliseconds within the second.  SoftClock_now reads
+ *  the clock from RAM, with no I2C traffic.
+ *
+ *  The clock is set from the RTC at the first edge, and read again every SOFTCLOCK_RESYNC_SECS in case an
+ *  edge was missed.  Each read is made just after an edge, so the RTC's seconds can't roll over during it.
+ *  The RTC must be in 24-hour format.
+ *
+ *  Uses INT0 and Timer1.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "SoftClock.h"
+
+
+static RTC_DateTime clockTime;				//Time at the last edge
+static volatile uint16_t edgeCount;			//Edges since the clock was last read from the RTC
+static volatile uint8_t isClockSet = 0;		//1 = clockTime has been read from the RTC
+static uint16_t lastEdgeCount;				//edgeCount when SoftClock_service last ran
+static uint8_t clockDevice;					//I2C address of the RTC
+
+
+
+/**
+* @brief	Move the clock on by one second
+*
+* @param[in,out]	dateTime	The date and time
+*
+* @return	none
+************************************************************************/
+static void SoftClock_addSecond(RTC_DateTime *dateTime)
+{
+	if (++dateTime->second < 60)
+	{
+		return;
+	}
+	dateTime->second = 0;
+	
+	if (++dateTime->minute < 60)
+	{
+		return;
+	}
+	dateTime->minute = 0;
+	
+	if (++dateTime->hour < 24)
+	{
+		return;
+	}
+	dateTime->hour = 0;
+	
+	if (++dateTime->weekDay > 7)
+	{
+		dateTime->weekDay = 1;
+	}
+	
+	if (++dateTime->day <= RTC_daysInMonth(dateTime->year, dateTime->month))
+	{
+		return;
+	}
+	dateTime->day = 1;
+	
+	if (++dateTime->month <= 12)
+	{
+		return;
+	}
+	dateTime->month = 1;
+	
+	if (++dateTime->year > 99)
+	{
+		dateTime->year = 0;
+	}
+}
+
+
+
+/**
+* @brief	Start the clock
+*
+* @details	Enables the RTC's 1Hz square wave on MFP, the INT0 interrupt on its edges, and Timer1.
+*			The clock is set from the RTC by SoftClock_service, at the first edge.  Enable interrupts after.
+*
+* @param[in]	deviceAddress	The I2C address of the RTC device
+*
+* @return	none
+************************************************************************/
+void SoftClock_init(uint8_t deviceAddress)
+{
+	uint8_t controlData;
+	
+	clockDevice = deviceAddress;
+	isClockSet = 0;
+	
+	//Square wave output on MFP, at 1Hz (SQWFS = 00).  The other CONTROL bits, such as EXTOSC, are kept
+	controlData = RTC_read(deviceAddress, MCP794_CONTROL);
+	controlData &= ~((1<<MCP794_SQWFS1) | (1<<MCP794_SQWFS0));
+	controlData |= (1<<MCP794_SQWEN);
+	RTC_write(deviceAddress, MCP794_CONTROL, controlData);
+	
+	//Timer1: Normal mode, prescaler 256.  Reset by each edge
+	TCCR1A = 0;
+	TCCR1B = (1<<CS12);
+	
+	//INT0 (PD2): input with pull-up (MFP is open-drain), interrupt on SOFTCLOCK_EDGE
+	DDRD &= ~(1<<PD2);
+	PORTD |= (1<<PD2);
+	EICRA = (EICRA & ~((1<<ISC01) | (1<<ISC00))) | SOFTCLOCK_EDGE;
+	EIFR = (1<<INTF0);	//Clear any old edge
+	EIMSK |= (1<<INT0);
+}
+
+
+
+/**
+* @brief	Read the clock from the RTC when it is due
+*
+* @details	Call regularly from the main loop - at least every SOFTCLOCK_RESYNC_WINDOW_MS to be sure of
+*			setting the clock at the first edge.  When the clock is due to be read, waits for the start of a
+*			second and reads it in a single burst read.
+*
+* @return	none
+************************************************************************/
+void SoftClock_service(void)
+{
+	RTC_DateTime readTime;
+	uint8_t sreg = SREG;
+	uint16_t readEdgeCount;
+	
+	cli();	//edgeCount is 16 bits, updated by the interrupt
+	readEdgeCount = edgeCount;
+	SREG = sreg;
+	
+	if (isClockSet && (readEdgeCount < SOFTCLOCK_RESYNC_SECS))
+	{
+		return;	//Not due
+	}
+	
+	if (readEdgeCount == lastEdgeCount)
+	{
+		return;	//Wait for an edge
+	}
+	lastEdgeCount = readEdgeCount;
+	
+	if (TCNT1 >= (uint16_t)((SOFTCLOCK_RESYNC_WINDOW_MS * SOFTCLOCK_TIMER_HZ) / 1000UL))
+	{
+		return;	//Too long since the edge - wait for the next one
+	}
+	
+	if (!RTC_GetTime(clockDevice, &readTime))
+	{
+		return;	//Try again at the next edge
+	}
+	
+	cli();
+	
+	if (edgeCount == readEdgeCount)	//No edge during the read
+	{
+		clockTime = readTime;
+		edgeCount = 0;
+		lastEdgeCount = 0;
+		isClockSet = 1;
+	}
+	
+	SREG = sreg;
+}
+
+
+
+/**
+* @brief	Read the clock
+*
+* @details	Reads from RAM: no I2C traffic.
+*
+* @param[out]	dateTime		The date and time
+* @param[out]	milliseconds	Milliseconds into the second (0-999)
+*
+* @return	1 = Success; 0 = The clock hasn't been set from the RTC yet
+************************************************************************/
+uint8_t SoftClock_now(RTC_DateTime *dateTime, uint16_t *milliseconds)
+{
+	uint8_t sreg = SREG;
+	uint16_t timerCount;
+	
+	cli();	//Read the time and the timer at the same edge
+	*dateTime = clockTime;
+	timerCount = TCNT1;
+	SREG = sreg;
+	
+	*milliseconds = (uint16_t)(((uint32_t)timerCount * SOFTCLOCK_MS_MULTIPLIER) >> 16);
+	if (*milliseconds > 999)
+	{
+		*milliseconds = 999;	//Edge is late
+	}
+	
+	return isClockSet;
+}
+
+
+
+/**
+* @brief	Interrupt Handler for INT0
+*
+* @details	Not called from user code.  Called on each edge of the RTC's square wave, at the start of
+*			each second.
+*
+* @return	none
+************************************************************************/
+ISR(INT0_vect)
+{
+	TCNT1 = 0;	//Start timing the second
+	
+	if (isClockSet)
+	{
+		SoftClock_addSecond(&clockTime);
+	}
+	
+	edgeCount++;
+}
@@ -0,0 +1,44 @@
+/*
+ * @file	SoftClock.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef SOFTCLOCK_H_
+#define SOFTCLOCK_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "RTC_MCP79400.h"
+
+#ifndef SOFTCLOCK_RESYNC_SECS
+#define SOFTCLOCK_RESYNC_SECS	3600	//Interval between reads of the time from the RTC, to catch any missed edges
+#endif
+
+#ifndef SOFTCLOCK_EDGE
+#define SOFTCLOCK_EDGE			(1<<ISC01)	//Edge of the square wave counted: falling.  The RTC's seconds increment on it
+#endif
+
+#define SOFTCLOCK_RESYNC_WINDOW_MS	100		//The RTC is only read this soon after an edge, so the read can't span the next one
+
+//Timer1 runs at F_CPU / 256, and is reset on each edge: its count is the time since the second started
+#define SOFTCLOCK_TIMER_HZ		(F_CPU / 256UL)
+#define SOFTCLOCK_MS_MULTIPLIER	(uint16_t)((1000UL * 65536UL) / SOFTCLOCK_TIMER_HZ)	//Timer1 count * this >> 16 = milliseconds
+
+#if SOFTCLOCK_TIMER_HZ > 65535
+#error "F_CPU too high: Timer1 would overflow within a second"
+#endif
+
+
+void SoftClock_init(uint8_t deviceAddress);
+void SoftClock_service(void);
+uint8_t SoftClock_now(RTC_DateTime *dateTime, uint16_t *milliseconds);
+
+
+
+#endif /* SOFTCLOCK_H_ */
@@ -13,8 +13,14 @@
  *    - Checks whether the time on the RTC is set
  *    - If time is not set, it sets it to 31/12/2015 23:59:15
  *
- *  In the main loop the application reads the time every 5 seconds, and prints
- *  it out to the UART
+ *    - Starts a clock in RAM, kept in step by the RTC's 1Hz square wave
+ *
+ *  In the main loop the application reads the time from the RAM clock (with no I2C
+ *  traffic), and prints it out to the UART every 5 seconds, to the millisecond
+ *
+ *  Set RTC_DEMO_MODE to RTC_DEMO_ALARM to instead sleep in Power-down, woken every 5 seconds
+ *  by the RTC's Alarm 0 to read and print the time.  Set it to RTC_DEMO_BENCHMARK to time the
+ *  conversions to and from seconds since 2000 (RTCTime), in CPU cycles
  *
  *  ------------------------------------
  *  @author	Andrew Retallack, Crash-Bang Prototyping
@@ -22,6 +28,10 @@
  *  @date	15/08/2015
  *
  *
+ *  CONNECTIONS
+ *  ===========
+ *  Connect the RTC's MFP pin to PD2 (INT0 / PCINT18)
+ *
  */
 
  //
@@ -37,7 +47,11 @@
 *  Include Files
 ***********************************/
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include "RTC_MCP79400.h"
+#include "RTCAlarm.h"
+#include "RTCTime.h"
+#include "SoftClock.h"
 #include "uart.h"
 
 /**********************************
@@ -45,19 +59,36 @@
 ***********************************/
 #define RTC_ADDRESS 0b11011110	//I2C Address for the MCP79400 RTC.  Only first 7 bits form address.
 
+#define RTC_DEMO_SOFTCLOCK 0	//Print the time from the RAM clock
+#define RTC_DEMO_ALARM 1		//Sleep, and wake on the RTC alarm to print the time
+#define RTC_DEMO_BENCHMARK 2	//Time the epoch conversions
+#ifndef RTC_DEMO_MODE
+	#define RTC_DEMO_MODE RTC_DEMO_SOFTCLOCK
+#endif
+
+#define ALARM_INTERVAL_SECS 5	//Seconds between alarms in RTC_DEMO_ALARM mode
+
+#define BENCHMARK_SAMPLES 1000		//Conversions timed in RTC_DEMO_BENCHMARK mode
+#define BENCHMARK_STEP 3155759UL	//Seconds between the epochs timed: spreads the samples over 2000-2099
+
 
 /**********************************
 *  Global Variables (for simplicity)
 ***********************************/
 uint8_t tempVar = 0;	//Temporary Variable
-uint8_t timeSec = 0;	//Time - Seconds
-uint8_t timeMin = 0;	//Time - Minutes
-uint8_t timeHr = 0;		//Time - Hours (24-hr)
-uint8_t timeDay = 0;		//Date - Day
-uint8_t timeWeekDay = 0;	//Date - Day of Week
-uint8_t timeMonth = 0;		//Date - Month
-uint16_t timeYear = 0;		//Date - Year
-uint8_t timeAmPm = 0;		//Date - AM/PM indicator
+RTC_DateTime timeNow;	//Date and Time read from the RTC
+uint16_t timeMillis = 0;	//Time - Milliseconds
+uint8_t lastPrintSec = 0xFF;	//Seconds when the time was last printed
+const RTC_DateTime timeDefault = {15, 12, 31, 5, 23, 0, 59, 15};	//Date and Time set if the RTC isn't set: 31/12/2015 (a Thursday) 23:59:15
+RTC_DateTime timeAlarm;	//Time the next alarm goes off (only the seconds are matched)
+volatile uint32_t epochNow;	//Result of the conversions being timed - volatile, so they aren't optimised away
+
+
+/**********************************
+*  Function Prototypes
+***********************************/
+void printTime(void);
+void benchmarkTime(void);
 
 
 int main(void)
@@ -67,8 +98,11 @@ int main(void)
 	UART_Init(9600);
 	UART_writeString("Welcome\r\n");
 	
-	//Initialise the I2C Interface at 200kHz
-	I2C_init(200);
+	//Initialise the I2C Interface at I2C_SCL_HZ (400kHz), and show the speed achieved
+	I2C_init();
+	UART_writeString("I2C bus: ");
+	UART_printDecimal(I2C_SCL_ACTUAL_HZ / 1000UL, 0);
+	UART_writeString("kHz\r\n");
 	
 	//Initialise the RTC, and show whether oscillator started successfully
 	if (RTC_Init(RTC_ADDRESS, 1, 1))
@@ -82,13 +116,13 @@ int main(void)
 	
 	
 	//Read the Time from the RTC
-	tempVar = RTC_GetTime(RTC_ADDRESS, &timeYear, &timeMonth, &timeDay, &timeWeekDay, &timeHr, &timeAmPm, &timeMin, &timeSec);	
+	tempVar = RTC_GetTime(RTC_ADDRESS, &timeNow);
 	
 	//If Year is one and month is one and day is one, assume time not set (these are the Power-On-Reset values).
 	//Set the Time
-	if ((timeYear == 1) && (timeMonth ==1) && (timeDay == 1))
+	if ((timeNow.year == 1) && (timeNow.month == 1) && (timeNow.day == 1))
 	{
-		tempVar = RTC_SetTime(RTC_ADDRESS, 15,12,31,5,23,1,59,15);
+		tempVar = RTC_SetTime(RTC_ADDRESS, &timeDefault);
 	}
 	
 
@@ -106,33 +140,153 @@ int main(void)
 		#endif
 	}
 	
+#if RTC_DEMO_MODE == RTC_DEMO_ALARM
+	//Wake on the RTC's alarm: set Alarm 0 to go off when the seconds next reach a multiple of ALARM_INTERVAL_SECS
+	RTCAlarm_init(RTC_ADDRESS);
+	RTC_GetTime(RTC_ADDRESS, &timeAlarm);
+	timeAlarm.second = ((timeAlarm.second / ALARM_INTERVAL_SECS + 1) * ALARM_INTERVAL_SECS) % 60;
+	RTC_setAlarm(RTC_ADDRESS, 0, &timeAlarm, RTC_ALARM_MATCH_SECONDS);
+	sei();
+	
+	while(1)
+	{
+		UART_flush();		//Power-down stops the UART, so finish sending first
+		RTCAlarm_sleep();	//Nothing runs until the alarm goes off
+		
+		if (RTCAlarm_service() & (1<<0))
+		{
+			//Rearm for the next interval - the alarm is only set again, not polled
+			timeAlarm.second = (timeAlarm.second + ALARM_INTERVAL_SECS) % 60;
+			RTC_setAlarm(RTC_ADDRESS, 0, &timeAlarm, RTC_ALARM_MATCH_SECONDS);
+			
+			RTC_GetTime(RTC_ADDRESS, &timeNow);
+			timeMillis = 0;	//The alarm goes off as the second starts
+			printTime();
+		}
+	}
+#elif RTC_DEMO_MODE == RTC_DEMO_BENCHMARK
+	benchmarkTime();
+	
+	while(1)
+	{
+	}
+#else
+	//Start the RAM clock.  It is set from the RTC at the next tick of the square wave
+	SoftClock_init(RTC_ADDRESS);
+	sei();
+	
     while(1)
     {
-		_delay_ms(5000);	//Only read the time every 5 seconds
-		
-		//Read the Time
-		tempVar = RTC_GetTime(RTC_ADDRESS, &timeYear, &timeMonth, &timeDay, &timeWeekDay, &timeHr, &timeAmPm, &timeMin, &timeSec);	//Reset minutes to zero
+		SoftClock_service();	//Read the time from the RTC when due
 		
-		//Print the time over the UART
-		UART_writeString("\r\nTimecheck: ");
-		UART_printDecimal(timeDay,2);
-		UART_writeString("/");
-		UART_printDecimal(timeMonth,2);
-		UART_writeString("/20");
-		UART_printDecimal(timeYear,2);
-		
-		UART_writeString("   ");
-		UART_printDecimal(timeHr,2);
-		UART_writeString(":");
-		UART_printDecimal(timeMin,2);
-		UART_writeString(":");
-		UART_printDecimal(timeSec,2);
-		UART_writeString("\r\n");
-
+		//Read the Time - from RAM, so it costs nothing to read it continuously
+		if (!SoftClock_now(&timeNow, &timeMillis) || (timeNow.second == lastPrintSec) || ((timeNow.second % 5) != 0))
+		{
+			continue;	//Only print the time every 5 seconds
+		}
+		lastPrintSec = timeNow.second;
 		
+		printTime();
     }
+#endif
 }
 
 
 
+/**
+* @brief	Print timeNow and timeMillis over the UART
+*
+* @return	none
+************************************************************************/
+void printTime(void)
+{
+	//Print the time over the UART
+	UART_writeString("\r\nTimecheck: ");
+	UART_printDecimal(timeNow.day,2);
+	UART_writeString("/");
+	UART_printDecimal(timeNow.month,2);
+	UART_writeString("/20");
+	UART_printDecimal(timeNow.year,2);
+	
+	UART_writeString("   ");
+	UART_printDecimal(timeNow.hour,2);
+	UART_writeString(":");
+	UART_printDecimal(timeNow.minute,2);
+	UART_writeString(":");
+	UART_printDecimal(timeNow.second,2);
+	UART_writeString(".");
+	UART_printDecimal(timeMillis,3);
+	UART_writeString("\r\n");
+}
+
+
 
+/**
+* @brief	Time the conversions to and from an epoch, and print the results over the UART
+*
+* @details	Timer1 runs at F_CPU, so counts CPU cycles.  Each conversion is timed once for each of
+*			BENCHMARK_SAMPLES dates and times, and converted back to check the result.
+*
+* @return	none
+************************************************************************/
+void benchmarkTime(void)
+{
+	uint16_t startCount;
+	uint16_t cycles;
+	uint16_t overhead;
+	uint16_t maxFrom = 0;
+	uint16_t maxTo = 0;
+	uint32_t totalFrom = 0;
+	uint32_t totalTo = 0;
+	uint16_t errors = 0;
+	uint32_t epoch;
+	uint16_t sample;
+	
+	TCCR1A = 0;
+	TCCR1B = (1<<CS10);	//Normal mode, no prescaler: one count per cycle
+	
+	startCount = TCNT1;
+	overhead = TCNT1 - startCount;	//Cycles taken by reading the timer
+	
+	for (sample = 0; sample < BENCHMARK_SAMPLES; sample++)
+	{
+		epoch = sample * BENCHMARK_STEP;
+		
+		startCount = TCNT1;
+		RTCTime_fromEpoch(epoch, &timeNow);
+		cycles = TCNT1 - startCount - overhead;
+		totalFrom += cycles;
+		if (cycles > maxFrom)
+		{
+			maxFrom = cycles;
+		}
+		
+		startCount = TCNT1;
+		epochNow = RTCTime_toEpoch(&timeNow);
+		cycles = TCNT1 - startCount - overhead;
+		totalTo += cycles;
+		if (cycles > maxTo)
+		{
+			maxTo = cycles;
+		}
+		
+		if (epochNow != epoch)
+		{
+			errors++;
+		}
+	}
+	
+	TCCR1B = 0;
+	
+	UART_writeString("\r\nRTCTime_fromEpoch: average ");
+	UART_printDecimal(totalFrom / BENCHMARK_SAMPLES, 0);
+	UART_writeString(", max ");
+	UART_printDecimal(maxFrom, 0);
+	UART_writeString(" cycles\r\nRTCTime_toEpoch: average ");
+	UART_printDecimal(totalTo / BENCHMARK_SAMPLES, 0);
+	UART_writeString(", max ");
+	UART_printDecimal(maxTo, 0);
+	UART_writeString(" cycles\r\nErrors: ");
+	UART_printDecimal(errors, 0);
+	UART_writeString("\r\n");
+}
@@ -11,6 +11,9 @@
 #include "uart.h"
 
 
+static uint8_t isCharWritten = 0;	//1 = A character has been written since UART_Init - so TXC0 will be set once it is sent
+
+
 /**
 * @brief	Initialise the UART in Asynchronous Mode
 *
@@ -71,6 +74,29 @@ void UART_writeChar(unsigned char data)
 	//write char
 	UDR0 = data;
 	
+	//Clear Transmit Complete - it is set again once this character has been sent.  Cleared after loading
+	//UDR0, so the previous character finishing can't leave it set.  FE0, DOR0 and UPE0 must be written
+	//as 0, so only U2X0 and MPCM0 are kept
+	UCSR0A = (UCSR0A & ((1<<U2X0)|(1<<MPCM0))) | (1<<TXC0);
+	isCharWritten = 1;
+	
+}
+
+
+
+/**
+* @brief	Waits until all characters written have been sent
+*
+* @details	Call before sleeping in a mode that stops the UART's clock, so the last character isn't cut off
+*
+* @return	none
+************************************************************************/
+void UART_flush(void)
+{
+	if (isCharWritten)
+	{
+		while ( !(UCSR0A & (1<<TXC0) ) );
+	}
 }
 
 
@@ -21,6 +21,7 @@ void UART_Init(uint16_t baudRate);
 void UART_writeChar(unsigned char data);
 void UART_writeString(const char dataString[]);
 void UART_printDecimal(uint16_t what, uint8_t padDigits);
+void UART_flush(void);
 
 
 
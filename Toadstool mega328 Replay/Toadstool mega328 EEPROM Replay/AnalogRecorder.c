@@ -0,0 +1,294 @@
+/*
+ * @file	AnalogRecorder.c
+ *
+ *  Records an analog input with the ADC, and replays it as a PWM output
+ *
+ *  The ADC free-runs, and its interrupt averages each ANALOG_DECIMATION conversions into one 8-bit sample.
+ *  The ADC is also the sample clock for replay - so a recording replays at exactly the rate it was made,
+ *  without another timer.
+ *
+ *  Samples pass through two page-sized buffers.  When recording, the interrupt fills one buffer while the
+ *  main loop writes the other to the EEPROM volume with a single page write.  When replaying, the interrupt
+ *  plays one buffer while the main loop reads the next page into the other.  At about 500 samples/sec a
+ *  64-byte page lasts over 120ms, much longer than a page write, so the stream has no gaps.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "AnalogRecorder.h"
+
+
+static uint8_t pageBuffers[2][EEPROM_PAGE_SIZE];	//Double buffer of samples
+static volatile uint8_t isBufferReady[2];	//Recording: buffer full, waiting to be written.  Replay: buffer loaded, waiting to be played
+static volatile uint8_t activeBuffer;		//Buffer the interrupt is using
+static volatile uint8_t sampleIndex;		//Next sample in the active buffer
+static uint8_t serviceBuffer;				//Next buffer for the main loop to write (recording) or load (replay)
+
+static volatile uint8_t isRecording;		//1 = ADC interrupt records, 0 = ADC interrupt replays
+static uint8_t conversionCount;				//Conversions added to conversionSum so far
+static uint16_t conversionSum;				//Sum of the conversions for the current sample
+
+static PageStream analogStream;		//The recording in the EEPROM volume
+
+volatile uint16_t analogOverruns = 0;
+volatile uint16_t analogUnderruns = 0;
+
+
+
+/**
+* @brief	Start the ADC free-running, with an interrupt on each conversion
+*
+* @return	none
+************************************************************************/
+static void AnalogRecorder_startADC(void)
+{
+	conversionCount = 0;
+	conversionSum = 0;
+	
+	ADMUX = (1<<REFS0) | ANALOG_CHANNEL;	//AVcc reference, right-adjusted result, selected channel
+	ADCSRB = 0;								//Auto trigger source: Free Running
+	DIDR0 |= (1<<ANALOG_CHANNEL);			//Disable the digital input on the channel's pin
+	
+	//Enable, auto trigger, interrupt, prescaler 128 (125kHz ADC clock at 16MHz), and start
+	ADCSRA = (1<<ADEN) | (1<<ADATE) | (1<<ADIE) | (1<<ADPS2) | (1<<ADPS1) | (1<<ADPS0) | (1<<ADSC);
+}
+
+
+
+/**
+* @brief	Stop the ADC
+*
+* @return	none
+************************************************************************/
+static void AnalogRecorder_stopADC(void)
+{
+	ADCSRA = 0;
+}
+
+
+
+/**
+* @brief	Start the buffers empty, with the interrupt on buffer 0
+*
+* @return	none
+************************************************************************/
+static void AnalogRecorder_resetBuffers(void)
+{
+	isBufferReady[0] = 0;
+	isBufferReady[1] = 0;
+	activeBuffer = 0;
+	sampleIndex = 0;
+	serviceBuffer = 0;
+}
+
+
+
+/**
+* @brief	Start recording
+*
+* @param[in]	startAddress	Volume address for the first page of the recording.  Must be the start of a page
+*
+* @return	none
+************************************************************************/
+void AnalogRecorder_startRecord(uint32_t startAddress)
+{
+	PageStream_startWrite(&analogStream, startAddress);
+	
+	AnalogRecorder_resetBuffers();
+	isRecording = 1;
+	AnalogRecorder_startADC();
+}
+
+
+
+/**
+* @brief	Write full buffers to the EEPROM
+*
+* @details	Call from the main loop while recording.
+*
+* @return	1 = Recording; 0 = The volume is full, so the recording has stopped
+************************************************************************/
+uint8_t AnalogRecorder_serviceRecord(void)
+{
+	while (isBufferReady[serviceBuffer])
+	{
+		if (PageStream_isFull(&analogStream))
+		{
+			AnalogRecorder_stopADC();	//Full
+			return 0;
+		}
+		
+		PageStream_writePage(&analogStream, pageBuffers[serviceBuffer]);
+		
+		isBufferReady[serviceBuffer] = 0;	//Interrupt can fill it again
+		serviceBuffer ^= 1;
+	}
+	
+	return 1;
+}
+
+
+
+/**
+* @brief	Stop recording
+*
+* @details	Writes the full buffers, then the part-filled one.  The interrupt only fills a buffer that
+*			isn't waiting to be written, so the active buffer holds sampleIndex samples.
+*
+* @return	Number of pages in the recording
+************************************************************************/
+uint16_t AnalogRecorder_stopRecord(void)
+{
+	AnalogRecorder_stopADC();
+	
+	AnalogRecorder_serviceRecord();
+	
+	return PageStream_finishWrite(&analogStream, pageBuffers[activeBuffer], sampleIndex);
+}
+
+
+
+/**
+* @brief	Start replaying
+*
+* @details	Loads both buffers, and starts the PWM output and the ADC (as the sample clock).
+*			The recording is replayed in a loop.  With no pages, nothing is replayed.
+*
+* @param[in]	startAddress	Volume address of the first page of the recording
+* @param[in]	pages			Number of pages in the recording
+*
+* @return	none
+************************************************************************/
+void AnalogRecorder_startReplay(uint32_t startAddress, uint16_t pages)
+{
+	if (!PageStream_startRead(&analogStream, startAddress, pages))
+	{
+		return;	//Nothing to replay
+	}
+	
+	AnalogRecorder_resetBuffers();
+	AnalogRecorder_serviceReplay();	//Load both buffers before the first sample
+	
+	//Timer0: Fast PWM, non-inverting output on OC0B, no prescaler
+	OCR0B = pageBuffers[0][0];
+	TCCR0A = (1<<COM0B1) | (1<<WGM01) | (1<<WGM00);
+	TCCR0B = (1<<CS00);
+	ANALOG_PWM_DDR |= (1<<ANALOG_PWM_PIN);
+	
+	isRecording = 0;
+	AnalogRecorder_startADC();
+}
+
+
+
+/**
+* @brief	Load the next pages of the recording into the buffers
+*
+* @details	Call from the main loop while replaying.  Loops back to the start of the recording at the end.
+*
+* @return	none
+************************************************************************/
+void AnalogRecorder_serviceReplay(void)
+{
+	if (!analogStream.isReading)
+	{
+		return;	//Not replaying
+	}
+	
+	while (!isBufferReady[serviceBuffer])
+	{
+		PageStream_read(&analogStream, pageBuffers[serviceBuffer], EEPROM_PAGE_SIZE);
+		
+		isBufferReady[serviceBuffer] = 1;	//Interrupt can play it
+		serviceBuffer ^= 1;
+	}
+}
+
+
+
+/**
+* @brief	Stop replaying
+*
+* @details	Stops the PWM output, leaving the pin low.
+*
+* @return	none
+************************************************************************/
+void AnalogRecorder_stopReplay(void)
+{
+	AnalogRecorder_stopADC();
+	
+	TCCR0A = 0;	//Disconnect OC0B: the pin follows PORTD again
+	TCCR0B = 0;
+	ANALOG_PWM_DDR &= ~(1<<ANALOG_PWM_PIN);
+	
+	PageStream_stopRead(&analogStream);
+}
+
+
+
+/**
+* @brief	Interrupt Handler for ADC Conversion Complete
+*
+* @details	Not called from user code.  Called after each conversion.  Every ANALOG_DECIMATION conversions,
+*			records the average as an 8-bit sample, or plays the next sample.
+*
+* @return	none
+************************************************************************/
+ISR(ADC_vect)
+{
+	uint8_t sample;
+	
+	conversionSum += ADC;
+	conversionCount++;
+	
+	if (conversionCount < ANALOG_DECIMATION)
+	{
+		return;
+	}
+	
+	if (isRecording)
+	{
+		sample = (uint8_t)((conversionSum / ANALOG_DECIMATION) >> 2);	//Average, reduced from 10 to 8 bits
+		
+		if (isBufferReady[activeBuffer])
+		{
+			analogOverruns++;	//Main loop hasn't written this buffer yet - drop the sample
+		}
+		else
+		{
+			pageBuffers[activeBuffer][sampleIndex++] = sample;
+			
+			if (sampleIndex >= EEPROM_PAGE_SIZE)
+			{
+				isBufferReady[activeBuffer] = 1;	//Full: hand it to the main loop
+				activeBuffer ^= 1;
+				sampleIndex = 0;
+			}
+		}
+	}
+	else
+	{
+		if (isBufferReady[activeBuffer])
+		{
+			OCR0B = pageBuffers[activeBuffer][sampleIndex++];
+			
+			if (sampleIndex >= EEPROM_PAGE_SIZE)
+			{
+				isBufferReady[activeBuffer] = 0;	//Played: hand it back to the main loop
+				activeBuffer ^= 1;
+				sampleIndex = 0;
+			}
+		}
+		else
+		{
+			analogUnderruns++;	//Main loop hasn't loaded this buffer yet - hold the output
+		}
+	}
+	
+	conversionCount = 0;
+	conversionSum = 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * @file	AnalogRecorder.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef ANALOGRECORDER_H_
+#define ANALOGRECORDER_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "PageStream.h"
+
+#ifndef ANALOG_CHANNEL
+#define ANALOG_CHANNEL		0		//ADC input recorded (ADC0 = PC0)
+#endif
+
+#ifndef ANALOG_DECIMATION
+#define ANALOG_DECIMATION	19		//ADC conversions averaged into each sample.  No more than 64
+#endif
+
+//The ADC free-runs at F_CPU / 128, taking 13 clocks per conversion: 9615 conversions/sec at 16MHz.
+//So samples are recorded (and replayed) at 9615 / ANALOG_DECIMATION: 506 samples/sec by default
+#define ANALOG_CONVERSION_HZ	(F_CPU / 128UL / 13UL)
+#define ANALOG_SAMPLE_HZ		(ANALOG_CONVERSION_HZ / ANALOG_DECIMATION)
+
+#if (ANALOG_DECIMATION < 1) || (ANALOG_DECIMATION > 64)
+#error "ANALOG_DECIMATION must be between 1 and 64"
+#endif
+
+//Replay is a PWM output on OC0B (PD5), at F_CPU / 256 (62.5kHz).  Filter with an RC low-pass filter
+#define ANALOG_PWM_DDR		DDRD
+#define ANALOG_PWM_PIN		PD5
+
+
+extern volatile uint16_t analogOverruns;	//Samples lost because the main loop didn't write a page in time
+extern volatile uint16_t analogUnderruns;	//Replay samples missed because the main loop didn't read a page in time
+
+
+void AnalogRecorder_startRecord(uint32_t firstAddress);
+uint8_t AnalogRecorder_serviceRecord(void);
+uint16_t AnalogRecorder_stopRecord(void);
+void AnalogRecorder_startReplay(uint32_t firstAddress, uint16_t pageCount);
+void AnalogRecorder_serviceReplay(void);
+void AnalogRecorder_stopReplay(void);
+
+
+
+#endif /* ANALOGRECORDER_H_ */
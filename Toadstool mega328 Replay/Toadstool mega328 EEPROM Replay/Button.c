@@ -0,0 +1,155 @@
+/*
+ * @file	Button.c
+ *
+ *  Interrupt-driven, debounced button
+ *
+ *  The pin change interrupt catches each edge as it happens.  The first edge of a press or release is
+ *  taken straight away, timestamped and queued, and edges for debounceTime after it are ignored as bounce -
+ *  so the button responds within microseconds, without waiting for the bouncing to stop.
+ *
+ *  If the button ends up at a different level once debounceTime is over (eg. a very short press), there is
+ *  no edge left to interrupt on - Button_service catches this, so call it regularly from the main loop.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "Button.h"
+
+
+static ButtonEvent buttonBuffer[BUTTON_QUEUE_SIZE];
+RingBuffer buttonQueue;
+
+static uint32_t (*buttonReadTime)(void);	//Time source
+static uint32_t buttonDebounceTime;		//Time to ignore edges for after each one taken, in the time source's units
+static uint32_t lastEdgeTime;			//Time of the last edge taken
+static volatile uint8_t isButtonPressed;	//Debounced level: 1 = Pressed
+
+
+
+/**
+* @brief	Take an edge, if the level has changed and the last edge has finished bouncing
+*
+* @details	Call with interrupts disabled, as the interrupt and the main loop both call it.
+*
+* @return	none
+************************************************************************/
+static void Button_check(void)
+{
+	ButtonEvent event;
+	
+	event.isPressed = ((PINB & (1<<BUTTON_PIN)) == 0);	//Pin is LOW when pressed
+	
+	if (event.isPressed == isButtonPressed)
+	{
+		return;	//No change
+	}
+	
+	event.time = buttonReadTime();
+	
+	if ((event.time - lastEdgeTime) < buttonDebounceTime)
+	{
+		return;	//Bounce
+	}
+	
+	isButtonPressed = event.isPressed;
+	lastEdgeTime = event.time;
+	
+	RingBuffer_put(&buttonQueue, &event);	//If full, the event is dropped and counted in buttonQueue.overflows
+}
+
+
+
+/**
+* @brief	Initialise the button
+*
+* @details	Sets the pin as an input with its pull-up resistor, and enables its pin change interrupt.
+*
+* @param[in]	readTime		Function returning the time now.  Called from the interrupt
+* @param[in]	debounceTime	Time to ignore edges for after each one, in readTime's units
+*
+* @return	none
+************************************************************************/
+void Button_init(uint32_t (*readTime)(void), uint32_t debounceTime)
+{
+	uint8_t sreg = SREG;
+	
+	cli();
+	
+	DDRB &= ~(1<<BUTTON_PIN);	//Set pin as an input
+	PORTB |= (1<<BUTTON_PIN);	//Enable pull-up resistor on pin
+	
+	buttonReadTime = readTime;
+	buttonDebounceTime = debounceTime;
+	lastEdgeTime = readTime() - debounceTime;	//First edge can be taken straight away
+	isButtonPressed = ((PINB & (1<<BUTTON_PIN)) == 0);
+	
+	RingBuffer_init(&buttonQueue, buttonBuffer, sizeof(ButtonEvent), BUTTON_QUEUE_SIZE);
+	
+	PCMSK0 |= (1<<BUTTON_PIN);	//Interrupt on changes of the pin
+	PCIFR = (1<<PCIF0);			//Clear any old change
+	PCICR |= (1<<PCIE0);		//Enable pin change interrupts on PORTB
+	
+	SREG = sreg;
+}
+
+
+
+/**
+* @brief	Get the next button event
+*
+* @param[out]	event	The event
+*
+* @return	1 = Success; 0 = No event waiting
+************************************************************************/
+uint8_t Button_getEvent(ButtonEvent *event)
+{
+	return RingBuffer_get(&buttonQueue, event);
+}
+
+
+
+/**
+* @brief	Check whether the button is pressed
+*
+* @return	1 = Pressed; 0 = Released (debounced)
+************************************************************************/
+uint8_t Button_isPressed(void)
+{
+	return isButtonPressed;
+}
+
+
+
+/**
+* @brief	Catch a change of level that happened while edges were being ignored as bounce
+*
+* @details	Call regularly from the main loop.
+*
+* @return	none
+************************************************************************/
+void Button_service(void)
+{
+	uint8_t sreg = SREG;
+	
+	cli();
+	Button_check();
+	SREG = sreg;
+}
+
+
+
+/**
+* @brief	Interrupt Handler for Pin Change on PORTB
+*
+* @details	Not called from user code.  Called on each edge of the button.
+*
+* @return	none
+************************************************************************/
+ISR(PCINT0_vect)
+{
+	Button_check();
+}
@@ -0,0 +1,48 @@
+/*
+ * @file	Button.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef BUTTON_H_
+#define BUTTON_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "RingBuffer.h"
+
+#ifndef BUTTON_PIN
+#define BUTTON_PIN			PB0		//Pin of the button on PORTB (PCINT0-7), connected to GND when pressed
+#endif
+
+#ifndef BUTTON_QUEUE_SIZE
+#define BUTTON_QUEUE_SIZE	8		//Number of events that can wait.  A power of 2, and no more than 128
+#endif
+
+
+/**
+* A debounced press or release of the button
+*/
+typedef struct
+{
+	uint32_t time;		//Time of the edge, from the time source given to Button_init
+	uint8_t isPressed;	//1 = Pressed; 0 = Released
+} ButtonEvent;
+
+
+extern RingBuffer buttonQueue;	//Events waiting.  buttonQueue.overflows counts any dropped
+
+
+void Button_init(uint32_t (*readTime)(void), uint32_t debounceTime);
+uint8_t Button_getEvent(ButtonEvent *event);
+uint8_t Button_isPressed(void);
+void Button_service(void);
+
+
+
+#endif /* BUTTON_H_ */
@@ -10,26 +10,172 @@
 
 #include "EEPROM.h"
 
+
+//One bit per device (selected by address pins A2-A0) that has a write cycle in progress
+#define EEPROM_PENDING_BIT(deviceAddress)	(1 << (((deviceAddress) >> 1) & 0x07))
+
+static uint8_t writePending = 0;	//Devices which may still be busy with an internal write cycle
+
+//Mask of the device address bits used to select a block of memory on parts with EEPROM_BLOCK_BITS
+#define EEPROM_BLOCK_MASK	(((1 << EEPROM_BLOCK_BITS) - 1) << 1)
+
+
+
+/**
+* @brief	Build the addressing for a memory address
+*
+* @details	Fills in the EEPROM_ADDRESS_BYTES memory address bytes to send after the device address,
+*			and returns the device address to use - including the block select bits for parts which
+*			take the high address bits in the device address.
+*			The part is fixed at compile time, so this reduces to a couple of shifts.
+*
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+* @param[in]	memoryAddress	The address in memory
+* @param[out]	addressBytes	Buffer for the EEPROM_ADDRESS_BYTES address bytes
+*
+* @return	The I2C address to send
+************************************************************************/
+static inline uint8_t EEPROM_setAddress(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t *addressBytes)
+{
+#if EEPROM_ADDRESS_BYTES == 2
+	addressBytes[0] = memoryAddress >> 8;		//Address High
+	addressBytes[1] = (uint8_t)memoryAddress;	//Address Low
+#else
+	addressBytes[0] = (uint8_t)memoryAddress;	//Address (low 8 bits)
+#endif
+
+#if EEPROM_BLOCK_BITS > 0
+	//Address bits 8+ go into device address bits 1+, in place of the A0-A2 pins (which these parts don't have)
+	deviceAddress = (deviceAddress & ~EEPROM_BLOCK_MASK) | ((memoryAddress >> 7) & EEPROM_BLOCK_MASK);
+#endif
+
+	return (uint8_t)deviceAddress;
+}
+
+
+
+//Check byte for a log record.  An erased record (all 0xFF) never has a valid check byte
+#define EEPROM_LOG_CHECK(sequence, addressHigh, addressLow)	((uint8_t)((sequence) ^ (addressHigh) ^ (addressLow) ^ 0x5A))
+
+static uint16_t logDevice;		//Device that the log state below belongs to
+static uint8_t isLogMounted = 0;	//1 once the log on logDevice has been searched
+static uint8_t logSlot;			//Slot holding the newest record
+static uint8_t logSequence;		//Sequence number of the newest record
+static uint16_t logLastAddress;	//Value of the newest record (EEPROM_LOG_EMPTY if none)
+
+
+
+/**
+* @brief	Read one record from the last address log
+*
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+* @param[in]	slot			The log slot to read
+* @param[out]	record			Buffer for the EEPROM_LOG_RECORD_SIZE bytes of the record
+*
+* @return	1 = Valid record; 0 = Erased, partly written or unreadable
+************************************************************************/
+static uint8_t EEPROM_readLogRecord(uint16_t deviceAddress, uint8_t slot, uint8_t *record)
+{
+	if (!EEPROM_readBlock(deviceAddress, EEPROM_LOG_LOCATION + ((uint16_t)slot * EEPROM_LOG_RECORD_SIZE), record, EEPROM_LOG_RECORD_SIZE))
+	{
+		return 0;
+	}
+	
+	return (record[3] == EEPROM_LOG_CHECK(record[0], record[1], record[2]));
+}
+
+
+
+/**
+* @brief	Find the newest record in the last address log
+*
+* @details	Records are written to the slots in order, each with a sequence number one higher than the last.
+*			So from slot 0 the sequence numbers count up by one per slot until the newest record, and after
+*			it are either erased, or left over from the previous time around (and so don't follow on).
+*			This means the newest record can be found with a binary search - about log2(EEPROM_LOG_SLOTS)
+*			record reads - rather than reading every slot.
+*			A record torn by a reset during its write fails its check byte, so the previous record is used.
+*
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+*
+* @return	none
+************************************************************************/
+static void EEPROM_mountLog(uint16_t deviceAddress)
+{
+	uint8_t record[EEPROM_LOG_RECORD_SIZE];
+	uint8_t firstSequence;
+	uint8_t lowSlot;	//Newest slot known to follow on from slot 0
+	uint8_t highSlot;	//Oldest slot known not to follow on from slot 0
+	uint8_t midSlot;
+	
+	logDevice = deviceAddress;
+	isLogMounted = 1;
+	
+	if (EEPROM_readLogRecord(deviceAddress, 0, record))
+	{
+		firstSequence = record[0];
+		logSlot = 0;
+		logSequence = record[0];
+		logLastAddress = (uint16_t)(record[1]<<8) | record[2];
+		
+		lowSlot = 0;
+		highSlot = EEPROM_LOG_SLOTS;
+		
+		while ((highSlot - lowSlot) > 1)
+		{
+			midSlot = (lowSlot + highSlot) / 2;
+			
+			if (EEPROM_readLogRecord(deviceAddress, midSlot, record) && ((uint8_t)(record[0] - firstSequence) == midSlot))
+			{
+				//Follows on from slot 0, so the newest record is here or later
+				lowSlot = midSlot;
+				logSlot = midSlot;
+				logSequence = record[0];
+				logLastAddress = (uint16_t)(record[1]<<8) | record[2];
+			}
+			else
+			{
+				highSlot = midSlot;	//Newest record is before here
+			}
+		}
+	}
+	else if (EEPROM_readLogRecord(deviceAddress, EEPROM_LOG_SLOTS - 1, record))
+	{
+		//Slot 0 is not valid, but the last slot is: the write to slot 0 was interrupted, so the last slot is the newest
+		logSlot = EEPROM_LOG_SLOTS - 1;
+		logSequence = record[0];
+		logLastAddress = (uint16_t)(record[1]<<8) | record[2];
+	}
+	else
+	{
+		//Nothing logged yet - the first record goes into slot 0
+		logSlot = EEPROM_LOG_SLOTS - 1;
+		logSequence = 0xFF;
+		logLastAddress = EEPROM_LOG_EMPTY;
+	}
+}
+
+
+
 /**
 * @brief	Retrieve address of last Logged item
 *
 * @details	This function helps to implement simple logging, 
-*			by retrieving the EEPROM address of the last item logged
+*			by retrieving the EEPROM address of the last item logged.
+*			The first call searches the log (see EEPROM_mountLog); later calls return the remembered value.
 *
 * @param[in]	deviceAddress	The I2C address of the EEPROM device
 *
-* @return	The last address in EEPROM
+* @return	The last address in EEPROM; EEPROM_LOG_EMPTY if nothing has been logged
 ************************************************************************/
 uint16_t EEPROM_getLastAddress(uint16_t deviceAddress)
 {
-	uint8_t lastHigh;
-	uint8_t lastLow;
+	if (!isLogMounted || (logDevice != deviceAddress))
+	{
+		EEPROM_mountLog(deviceAddress);
+	}
 	
-	//Addresses are 2 bytes, so need to read High and Low bytes
-	lastHigh = EEPROM_read(deviceAddress,EEPROM_ADDRESS_LOCATION);
-	lastLow = EEPROM_read(deviceAddress,EEPROM_ADDRESS_LOCATION + 1);
-	
-	return (uint16_t)(lastHigh<<8) | lastLow;
+	return logLastAddress;
 
 }
 
@@ -39,7 +185,10 @@ uint16_t EEPROM_getLastAddress(uint16_t deviceAddress)
 * @brief	Store address of last Log
 *
 * @details	This function helps to implement simple logging,
-*			by storing the EEPROM address of the last item logged
+*			by storing the EEPROM address of the last item logged.
+*			The address is written as a new record in the next slot of the log, in a single page write,
+*			so the previous value is never overwritten - a reset part way through leaves the previous value
+*			in place.  Nothing is written if the address has not changed.
 *
 * @param[in]	deviceAddress	The I2C address of the EEPROM device
 * @param[in]	lastAddress		The EEPROM memory location of last logged item
@@ -48,15 +197,29 @@ uint16_t EEPROM_getLastAddress(uint16_t deviceAddress)
 ************************************************************************/
 void EEPROM_setLastAddress(uint16_t deviceAddress, uint16_t lastAddress)
 {
-	uint8_t lastHigh;
-	uint8_t lastLow;
+	uint8_t record[EEPROM_LOG_RECORD_SIZE];
+	
+	if (EEPROM_getLastAddress(deviceAddress) == lastAddress)
+	{
+		return;
+	}
+	
+	//Move on to the next slot, wrapping around to the start of the log
+	logSlot++;
+	if (logSlot >= EEPROM_LOG_SLOTS)
+	{
+		logSlot = 0;
+	}
+	logSequence++;
 	
-	//Addresses are 2 bytes, so need to write High and Low bytes
-	lastHigh = (lastAddress >> 8);
-	lastLow = (uint8_t)lastAddress;
+	record[0] = logSequence;
+	record[1] = (lastAddress >> 8);		//Address High
+	record[2] = (uint8_t)lastAddress;	//Address Low
+	record[3] = EEPROM_LOG_CHECK(record[0], record[1], record[2]);
 	
-	EEPROM_write(deviceAddress, EEPROM_ADDRESS_LOCATION, lastHigh);
-	EEPROM_write(deviceAddress, EEPROM_ADDRESS_LOCATION+1, lastLow);
+	EEPROM_writeBlock(deviceAddress, EEPROM_LOG_LOCATION + ((uint16_t)logSlot * EEPROM_LOG_RECORD_SIZE), record, EEPROM_LOG_RECORD_SIZE);
+	
+	logLastAddress = lastAddress;
 	
 }
 
@@ -64,41 +227,75 @@ void EEPROM_setLastAddress(uint16_t deviceAddress, uint16_t lastAddress)
 /**
 * @brief	Write data to the EEPROM
 *
-* @details	This function writes data to the EEPROM from a specified address
+* @details	This function writes data to the EEPROM from a specified address.
+*			The EEPROM's internal write cycle continues after this function returns - the next access
+*			to the device (or EEPROM_waitReady) waits for it to complete using ACK polling.
 *
 * @param[in]	deviceAddress	The I2C address of the EEPROM device
 * @param[in]	memoryAddress	The address in memory to start writing to
 * @param[in]	data	The byte to be written to the EEPROM
 *
-* @return	1 = Success
+* @return	1 = Success; 0 = EEPROM did not acknowledge
 ************************************************************************/
 
 uint8_t EEPROM_write(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t data)
 {
-	uint8_t result;
-	uint8_t returnResult = 0;
-	
-	//Send START Condition
-	result = I2C_sendStart();
-	
-	//Send the device Address with WRITE
-	result = I2C_send(deviceAddress|TW_WRITE);
-
-	//Send Memory Location Address to write to (High)
-	result = I2C_send(memoryAddress >> 8);	//Address High
-
-	//Send Memory Location Address to write to (Low)
-	result = I2C_send((uint8_t)memoryAddress);	//Address Low
-
-	//Write Data to EEPROM
-	result = I2C_send(data);	//Data
+	return EEPROM_writeBlock(deviceAddress, memoryAddress, &data, 1);
+}
 
-	//Send STOP Condition
-	I2C_sendStop();
 
-	_delay_ms(10);
 
-	returnResult = 1;
+/**
+* @brief	Write a block of data to the EEPROM
+*
+* @details	This function writes a block of data to the EEPROM from a specified address.
+*			The block is split on page boundaries (EEPROM_PAGE_SIZE), and each part is written with a
+*			single page write.  ACK polling is used to wait for each page's write cycle to complete
+*			before the next page is sent.  The last page's write cycle continues after this returns.
+*
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+* @param[in]	memoryAddress	The address in memory to start writing to
+* @param[in]	data			The bytes to be written to the EEPROM
+* @param[in]	length			The number of bytes to write
+*
+* @return	1 = Success; 0 = EEPROM did not acknowledge
+************************************************************************/
+uint8_t EEPROM_writeBlock(uint16_t deviceAddress, uint16_t memoryAddress, const uint8_t *data, uint16_t length)
+{
+	uint8_t returnResult = 1;
+	uint8_t addressBytes[EEPROM_ADDRESS_BYTES];
+	uint8_t i2cAddress;
+	uint16_t pageLength;
+	
+	while (length > 0)
+	{
+		//Write up to the end of the current page - any more would wrap around to the start of the page
+		pageLength = EEPROM_PAGE_SIZE - (memoryAddress & (EEPROM_PAGE_SIZE - 1));
+		if (pageLength > length)
+		{
+			pageLength = length;
+		}
+		
+		//Memory Location Address to write to
+		i2cAddress = EEPROM_setAddress(deviceAddress, memoryAddress, addressBytes);
+		
+		EEPROM_waitReady(deviceAddress);	//Wait for the previous page to finish
+		
+		//Send the address followed by the page data, in one transaction
+		returnResult = I2C_writeBuffer(i2cAddress, addressBytes, EEPROM_ADDRESS_BYTES, data, pageLength);
+		
+		if (returnResult != 1)
+		{
+			break;	//Not acknowledged - no write cycle was started, and the rest of the block is abandoned
+		}
+		
+		writePending |= EEPROM_PENDING_BIT(deviceAddress);	//EEPROM is now busy with its write cycle
+		
+		memoryAddress += pageLength;
+		data += pageLength;
+		length -= pageLength;
+	}
+	
 	return returnResult;
 }
 
@@ -111,7 +308,6 @@ uint8_t EEPROM_write(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t dat
 *
 * @param[in]	deviceAddress	The I2C address of the EEPROM device
 * @param[in]	memoryAddress	The address in memory to read from
-* @param[in]	data	The byte to be written to the EEPROM
 *
 * @return	The byte read from EEPROM
 ************************************************************************/
@@ -120,35 +316,99 @@ uint8_t EEPROM_read(uint16_t deviceAddress, uint16_t memoryAddress)
 {
 	
 	uint8_t readData = 0;
-	uint8_t result;
-
 
-	//Send START Condition
-	result = I2C_sendStart();
+	EEPROM_readBlock(deviceAddress, memoryAddress, &readData, 1);
+	
+	return readData;
+	
+}
 
-	//Send the device Address with WRITE - we need to write in order to specify the address to read from
-	result = I2C_send(deviceAddress|TW_WRITE);
 
-	//Send Memory Location Address to read from (High)
-	result = I2C_send(memoryAddress >> 8);	//Address High
 
-	//Send Memory Location Address to read from (Low)
-	result = I2C_send((uint8_t)memoryAddress);	//Address Low
+/**
+* @brief	Read a block of data from the EEPROM
+*
+* @details	This function sets the EEPROM's address pointer once, and then streams the bytes
+*			(sequential read), so each data byte costs one byte on the bus.
+*			The EEPROM's address pointer is left at the byte after the last one read.
+*			Reads continue across block and page boundaries, and wrap from the last address to address 0.
+*
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+* @param[in]	memoryAddress	The address in memory to start reading from
+* @param[out]	data			Buffer for the bytes read
+* @param[in]	length			The number of bytes to read
+*
+* @return	1 = Success; 0 = EEPROM did not acknowledge
+************************************************************************/
+uint8_t EEPROM_readBlock(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t *data, uint16_t length)
+{
+	uint8_t addressBytes[EEPROM_ADDRESS_BYTES];
+	uint8_t i2cAddress;
+	
+	//Memory Location Address to read from
+	i2cAddress = EEPROM_setAddress(deviceAddress, memoryAddress, addressBytes);
+	
+	EEPROM_waitReady(deviceAddress);	//Wait for any write in progress to finish
+	
+	//Write the address, then RESTART and stream the data, in one transaction
+	return I2C_readBuffer(i2cAddress, addressBytes, EEPROM_ADDRESS_BYTES, data, length);
+}
 
 
-	//Send RESTART Condition - now we read from the memory address
-	result = I2C_sendStart();
 
+/**
+* @brief	Queue a read of a block of data from the EEPROM
+*
+* @details	This function fills in the transaction with a sequential read, and queues it on the
+*			interrupt-driven I2C transaction engine.  It returns straight away - the read is complete when
+*			transaction->status is no longer I2C_TXN_PENDING (or when transaction->callback is called).
+*			The caller sets transaction->callback (or NULL) before calling.
+*			If the EEPROM is busy with a write cycle the status will be I2C_TXN_NACK, and the read can be retried.
+*
+* @param[out]	transaction		The transaction to fill in and queue.  Must remain valid until complete
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+* @param[in]	memoryAddress	The address in memory to start reading from
+* @param[out]	data			Buffer for the bytes read.  Must remain valid until complete
+* @param[in]	length			The number of bytes to read
+*
+* @return	1 = Queued; 0 = I2C queue full
+************************************************************************/
+uint8_t EEPROM_queueRead(I2C_transaction *transaction, uint16_t deviceAddress, uint16_t memoryAddress, uint8_t *data, uint16_t length)
+{
+	transaction->deviceAddress = EEPROM_setAddress(deviceAddress, memoryAddress, transaction->prefix);
+	transaction->prefixLength = EEPROM_ADDRESS_BYTES;
+	transaction->writeData = NULL;
+	transaction->writeLength = 0;
+	transaction->readData = data;
+	transaction->readLength = length;
+	
+	return I2C_queue(transaction);
+}
 
-	//Send the device Address with READ
-	result = I2C_send(deviceAddress|TW_READ);
 
-	//Read the data returned by the EEPROM
-	readData = I2C_read(0);	//Read Data with NO ACK  (No ACK means we're done reading)
 
-	//Send STOP Condition
-	I2C_sendStop();
+/**
+* @brief	Wait for the EEPROM to finish its internal write cycle
+*
+* @details	If a write has been sent to the device, poll it until it acknowledges its address
+*			(repeated START + device address), which it does as soon as the write cycle is complete.
+*			Gives up after EEPROM_POLL_LIMIT polls.
+*			Returns immediately if no write has been sent since the last check.
+*
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+*
+* @return	1 = EEPROM ready; 0 = Timed out
+************************************************************************/
+uint8_t EEPROM_waitReady(uint16_t deviceAddress)
+{
+	uint8_t isReady = 1;
 	
-	return readData;
+	if (writePending & EEPROM_PENDING_BIT(deviceAddress))
+	{
+		isReady = I2C_pollAck(deviceAddress, EEPROM_POLL_LIMIT);
+		
+		writePending &= ~EEPROM_PENDING_BIT(deviceAddress);	//Don't poll again, even if timed out
+	}
 	
+	return isReady;
 }
@@ -16,13 +16,127 @@
 #include <util/delay.h>
 #include "I2C.h"
 
-#define EEPROM_ADDRESS_LOCATION	1	//Location in EEPROM to store last address location
+//Select the EEPROM part fitted, by its size in kbit: 1, 2, 4, 8, 16, 32, 64, 128, 256 or 512 (eg. "EEPROM_PART=256" for a 24LC256)
+//Each part's capacity, addressing and page size are fixed at compile time, so there is no run-time checking of the part
+#ifndef EEPROM_PART
+#define EEPROM_PART	128	//24LC128
+#endif
+
+//Part descriptors:
+// EEPROM_CAPACITY			Size of the EEPROM in bytes
+// EEPROM_ADDRESS_BYTES		Number of memory address bytes sent after the device address (1 or 2)
+// EEPROM_PAGE_SIZE			Page size in bytes - the most that can be written in one write cycle.  Must be a power of 2
+// EEPROM_WRITE_CYCLE_MS	Maximum time for the internal write cycle
+// EEPROM_BLOCK_BITS		Number of high memory address bits sent in the device address (bits 1-3), in place of
+//							the A0-A2 pins.  The device address bits they use are ignored
+#if EEPROM_PART == 1		//24LC01B
+#define EEPROM_CAPACITY			128UL
+#define EEPROM_ADDRESS_BYTES	1
+#define EEPROM_PAGE_SIZE		8
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		0
+#elif EEPROM_PART == 2		//24LC02B
+#define EEPROM_CAPACITY			256UL
+#define EEPROM_ADDRESS_BYTES	1
+#define EEPROM_PAGE_SIZE		8
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		0
+#elif EEPROM_PART == 4		//24LC04B
+#define EEPROM_CAPACITY			512UL
+#define EEPROM_ADDRESS_BYTES	1
+#define EEPROM_PAGE_SIZE		16
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		1
+#elif EEPROM_PART == 8		//24LC08B
+#define EEPROM_CAPACITY			1024UL
+#define EEPROM_ADDRESS_BYTES	1
+#define EEPROM_PAGE_SIZE		16
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		2
+#elif EEPROM_PART == 16		//24LC16B
+#define EEPROM_CAPACITY			2048UL
+#define EEPROM_ADDRESS_BYTES	1
+#define EEPROM_PAGE_SIZE		16
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		3
+#elif EEPROM_PART == 32		//24LC32A
+#define EEPROM_CAPACITY			4096UL
+#define EEPROM_ADDRESS_BYTES	2
+#define EEPROM_PAGE_SIZE		32
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		0
+#elif EEPROM_PART == 64		//24LC64
+#define EEPROM_CAPACITY			8192UL
+#define EEPROM_ADDRESS_BYTES	2
+#define EEPROM_PAGE_SIZE		32
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		0
+#elif EEPROM_PART == 128	//24LC128
+#define EEPROM_CAPACITY			16384UL
+#define EEPROM_ADDRESS_BYTES	2
+#define EEPROM_PAGE_SIZE		64
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		0
+#elif EEPROM_PART == 256	//24LC256
+#define EEPROM_CAPACITY			32768UL
+#define EEPROM_ADDRESS_BYTES	2
+#define EEPROM_PAGE_SIZE		64
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		0
+#elif EEPROM_PART == 512	//24LC512
+#define EEPROM_CAPACITY			65536UL
+#define EEPROM_ADDRESS_BYTES	2
+#define EEPROM_PAGE_SIZE		128
+#define EEPROM_WRITE_CYCLE_MS	5
+#define EEPROM_BLOCK_BITS		0
+#else
+#error "EEPROM_PART must be one of 1, 2, 4, 8, 16, 32, 64, 128, 256 or 512"
+#endif
+
+#define EEPROM_MAX_ADDRESS	(uint16_t)(EEPROM_CAPACITY - 1)	//Highest memory address on the part
+
+//Last address log: EEPROM_setLastAddress appends a record to a ring of slots rather than rewriting one location,
+//spreading the wear across the region.  Each record is {sequence, address high, address low, check}.
+//The region is reserved from EEPROM_LOG_LOCATION up to (not including) EEPROM_LOG_END
+#define EEPROM_LOG_LOCATION		0	//First address of the log region.  Must be a multiple of EEPROM_LOG_RECORD_SIZE
+#define EEPROM_LOG_RECORD_SIZE	4	//Bytes per log record
+
+#ifndef EEPROM_LOG_PAGES
+#define EEPROM_LOG_PAGES		4	//Number of EEPROM pages the log is spread across
+#endif
+
+#ifndef EEPROM_LOG_SLOTS
+#define EEPROM_LOG_SLOTS		(EEPROM_LOG_PAGES * EEPROM_PAGE_SIZE / EEPROM_LOG_RECORD_SIZE)	//Number of records in the log (default: EEPROM_LOG_PAGES pages)
+#endif
+
+#define EEPROM_LOG_END		(EEPROM_LOG_LOCATION + (EEPROM_LOG_SLOTS * EEPROM_LOG_RECORD_SIZE))	//First address after the log region
+#define EEPROM_LOG_EMPTY	0xFFFF	//Returned by EEPROM_getLastAddress when nothing has been logged
+
+#if (EEPROM_LOG_SLOTS < 2) || (EEPROM_LOG_SLOTS > 128)
+#error "EEPROM_LOG_SLOTS must be between 2 and 128"
+#endif
+
+#if (EEPROM_LOG_SLOTS * EEPROM_LOG_RECORD_SIZE) < (2 * EEPROM_PAGE_SIZE)
+#error "The last address log must span at least 2 EEPROM pages, or every record wears the same page"
+#endif
+
+#if (EEPROM_LOG_LOCATION % EEPROM_LOG_RECORD_SIZE) != 0
+#error "EEPROM_LOG_LOCATION must be a multiple of EEPROM_LOG_RECORD_SIZE, so no record spans a page boundary"
+#endif
+
+//Maximum number of ACK polls while waiting for a write cycle.  Each poll (START + address) takes about
+//10 SCL cycles, so this allows twice the maximum write cycle time before giving up
+#define EEPROM_POLL_LIMIT	(uint16_t)((2UL * EEPROM_WRITE_CYCLE_MS * I2C_SCL_ACTUAL_HZ) / (10UL * 1000UL))
 
 
 uint8_t EEPROM_write(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t data);
 uint8_t EEPROM_read(uint16_t deviceAddress, uint16_t memoryAddress);
+uint8_t EEPROM_readBlock(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t *data, uint16_t length);
+uint8_t EEPROM_queueRead(I2C_transaction *transaction, uint16_t deviceAddress, uint16_t memoryAddress, uint8_t *data, uint16_t length);
+uint8_t EEPROM_writeBlock(uint16_t deviceAddress, uint16_t memoryAddress, const uint8_t *data, uint16_t length);
 uint16_t EEPROM_getLastAddress(uint16_t deviceAddress);
 void EEPROM_setLastAddress(uint16_t deviceAddress, uint16_t lastAddress);
+uint8_t EEPROM_waitReady(uint16_t deviceAddress);
 
 
 
@@ -0,0 +1,161 @@
+/*
+ * @file	EEPROMCache.c
+ *
+ *  Write-back page cache for the EEPROM
+ *
+ *  Writes are made to copies of EEPROM pages held in RAM, and only mark the page as dirty;
+ *  the page is written back to the EEPROM with a single page write when it is evicted to make room for
+ *  another page, or when EEPROMCache_flush is called.  Repeated writes to the same page therefore cost
+ *  one write cycle (and one cycle of EEPROM wear) instead of one per byte.
+ *
+ *  Only the write side is cached: reads are made directly with EEPROM.c (eg. by Prefetch during replay),
+ *  so call EEPROMCache_flush before reading.  Nothing else may write to the cached pages directly.
+ *
+ *  The last address log (EEPROM_setLastAddress) is always written directly: a record held back in the
+ *  cache would be lost on a reset, which the log is there to survive.  Keep the log's pages out of the cache.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "EEPROMCache.h"
+
+
+/**
+* One page held in the cache
+*/
+typedef struct
+{
+	uint16_t deviceAddress;		//I2C address of the EEPROM device the page belongs to
+	uint16_t pageAddress;		//Memory address of the first byte of the page
+	uint8_t isValid;			//1 = Page holds data
+	uint8_t isDirty;			//1 = Page has been written to, and not written back yet
+	uint8_t lastUsed;			//Value of useCounter when last used (for least-recently-used eviction)
+	uint8_t data[EEPROM_PAGE_SIZE];
+} EEPROMCache_page;
+
+static EEPROMCache_page cachePages[EEPROM_CACHE_PAGES];
+static uint8_t useCounter = 0;
+
+EEPROMCache_stats eepromCacheStats = {0, 0, 0};
+
+
+
+/**
+* @brief	Write a page back to the EEPROM if it is dirty
+*
+* @param[in]	page	The cached page
+*
+* @return	none
+************************************************************************/
+static void EEPROMCache_writeBack(EEPROMCache_page *page)
+{
+	if (page->isValid && page->isDirty)
+	{
+		EEPROM_writeBlock(page->deviceAddress, page->pageAddress, page->data, EEPROM_PAGE_SIZE);
+		page->isDirty = 0;
+		eepromCacheStats.flushes++;
+	}
+}
+
+
+
+/**
+* @brief	Find the cached page holding an address, loading it if needed
+*
+* @details	If the page is not in the cache, the least-recently-used page is written back (if dirty)
+*			and replaced with the page read from the EEPROM.
+*
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+* @param[in]	memoryAddress	The address in memory
+*
+* @return	The cached page
+************************************************************************/
+static EEPROMCache_page *EEPROMCache_getPage(uint16_t deviceAddress, uint16_t memoryAddress)
+{
+	uint16_t pageAddress = memoryAddress & ~(EEPROM_PAGE_SIZE - 1);
+	EEPROMCache_page *page;
+	EEPROMCache_page *victim = &cachePages[0];
+	uint8_t iCount;
+	
+	useCounter++;
+	
+	for (iCount = 0; iCount < EEPROM_CACHE_PAGES; iCount++)
+	{
+		page = &cachePages[iCount];
+		
+		if (page->isValid && (page->pageAddress == pageAddress) && (page->deviceAddress == deviceAddress))
+		{
+			eepromCacheStats.hits++;
+			page->lastUsed = useCounter;
+			return page;
+		}
+		
+		//Pick the page to replace: an empty page if there is one, otherwise the least recently used
+		if (victim->isValid && (!page->isValid || ((uint8_t)(useCounter - page->lastUsed) > (uint8_t)(useCounter - victim->lastUsed))))
+		{
+			victim = page;
+		}
+	}
+	
+	eepromCacheStats.misses++;
+	
+	EEPROMCache_writeBack(victim);
+	
+	EEPROM_readBlock(deviceAddress, pageAddress, victim->data, EEPROM_PAGE_SIZE);
+	victim->deviceAddress = deviceAddress;
+	victim->pageAddress = pageAddress;
+	victim->isValid = 1;
+	victim->isDirty = 0;
+	victim->lastUsed = useCounter;
+	
+	return victim;
+}
+
+
+
+/**
+* @brief	Write a byte through the cache
+*
+* @details	The byte is written to the cached page, which is marked dirty.  It is only written to the
+*			EEPROM when the page is evicted, or EEPROMCache_flush is called.
+*
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+* @param[in]	memoryAddress	The address in memory to write to
+* @param[in]	data			The byte to be written
+*
+* @return	none
+************************************************************************/
+void EEPROMCache_write(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t data)
+{
+	EEPROMCache_page *page = EEPROMCache_getPage(deviceAddress, memoryAddress);
+	uint8_t offset = memoryAddress & (EEPROM_PAGE_SIZE - 1);
+	
+	if (page->data[offset] != data)	//Only dirty the page if the data actually changes
+	{
+		page->data[offset] = data;
+		page->isDirty = 1;
+	}
+}
+
+
+
+/**
+* @brief	Write all dirty pages back to the EEPROM
+*
+* @details	Pages stay in the cache, so later writes to them don't have to load them again
+*
+* @return	none
+************************************************************************/
+void EEPROMCache_flush(void)
+{
+	uint8_t iCount;
+	
+	for (iCount = 0; iCount < EEPROM_CACHE_PAGES; iCount++)
+	{
+		EEPROMCache_writeBack(&cachePages[iCount]);
+	}
+}
@@ -0,0 +1,41 @@
+/*
+ * @file	EEPROMCache.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef EEPROMCACHE_H_
+#define EEPROMCACHE_H_
+
+#include <avr/io.h>
+#include "EEPROM.h"
+
+#ifndef EEPROM_CACHE_PAGES
+#define EEPROM_CACHE_PAGES	2	//Number of EEPROM pages held in RAM (each uses EEPROM_PAGE_SIZE bytes)
+#endif
+
+
+/**
+* Counters showing how well the cache is working
+*/
+typedef struct
+{
+	uint16_t hits;		//Writes made to a page already in the cache
+	uint16_t misses;	//Writes that had to load a page from the EEPROM first
+	uint16_t flushes;	//Dirty pages written back to the EEPROM (one page write each)
+} EEPROMCache_stats;
+
+extern EEPROMCache_stats eepromCacheStats;
+
+
+void EEPROMCache_write(uint16_t deviceAddress, uint16_t memoryAddress, uint8_t data);
+void EEPROMCache_flush(void);
+
+
+
+#endif /* EEPROMCACHE_H_ */
@@ -0,0 +1,172 @@
+/*
+ * @file	EEPROMVolume.c
+ *
+ *  Several EEPROM chips on the same bus, presented as one linear address space
+ *
+ *  Consecutive pages of the volume are striped across the chips: page 0 is on chip 0, page 1 on chip 1,
+ *  and so on, wrapping back to chip 0.  After a page write, a chip is busy with its internal write cycle,
+ *  but EEPROM.c only waits for a chip when it is next accessed - so while one chip is writing, the next
+ *  pages are loaded into the other chips.  A long write only waits when it gets back around to a chip
+ *  whose write cycle has not finished, so write throughput rises with the number of chips until loading
+ *  the other chips takes longer than one write cycle.
+ *
+ *  The volume covers the whole of each chip.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "EEPROMVolume.h"
+
+
+//I2C address of a chip in the volume
+#define EEPROM_VOLUME_CHIP_ADDRESS(chip)	(EEPROM_VOLUME_BASE_ADDRESS | ((chip) << 1))
+
+
+
+/**
+* @brief	Find which chip, and where on it, holds a volume address
+*
+* @param[in]	volumeAddress	Address in the volume
+* @param[out]	chip			The chip holding the address (0 to EEPROM_VOLUME_CHIPS - 1)
+* @param[out]	chipPage		The page on that chip holding the address
+*
+* @return	none
+************************************************************************/
+static void EEPROMVolume_locate(uint32_t volumeAddress, uint8_t *chip, uint16_t *chipPage)
+{
+	uint32_t volumePage = volumeAddress / EEPROM_PAGE_SIZE;
+	
+	*chip = volumePage % EEPROM_VOLUME_CHIPS;
+	*chipPage = volumePage / EEPROM_VOLUME_CHIPS;
+}
+
+
+
+/**
+* @brief	Write a block of data to the volume
+*
+* @details	The block is split on page boundaries, and each page is written to its chip with a single
+*			page write.  Each chip's write cycle continues while the following pages are sent to the
+*			other chips; a chip is only waited for (with ACK polling) when it is written to again.
+*			The last pages' write cycles continue after this returns.
+*
+* @param[in]	volumeAddress	The address in the volume to start writing to
+* @param[in]	data			The bytes to be written
+* @param[in]	length			The number of bytes to write
+*
+* @return	1 = Success; 0 = A chip did not acknowledge
+************************************************************************/
+uint8_t EEPROMVolume_write(uint32_t volumeAddress, const uint8_t *data, uint16_t length)
+{
+	uint8_t returnResult = 1;
+	uint8_t chip;
+	uint16_t chipPage;
+	uint8_t pageOffset = volumeAddress & (EEPROM_PAGE_SIZE - 1);
+	uint16_t pageLength;
+	
+	EEPROMVolume_locate(volumeAddress, &chip, &chipPage);	//Only the first page needs a division - then step through the chips
+	
+	while (returnResult && (length > 0))
+	{
+		//Write up to the end of the current page - the next page is on the next chip
+		pageLength = EEPROM_PAGE_SIZE - pageOffset;
+		if (pageLength > length)
+		{
+			pageLength = length;
+		}
+		
+		returnResult = EEPROM_writeBlock(EEPROM_VOLUME_CHIP_ADDRESS(chip), (chipPage * EEPROM_PAGE_SIZE) + pageOffset, data, pageLength);
+		
+		data += pageLength;
+		length -= pageLength;
+		pageOffset = 0;
+		
+		//Move onto the next chip, and the next page of each chip once past the last chip
+		chip++;
+		if (chip >= EEPROM_VOLUME_CHIPS)
+		{
+			chip = 0;
+			chipPage++;
+		}
+	}
+	
+	return returnResult;
+}
+
+
+
+/**
+* @brief	Read a block of data from the volume
+*
+* @details	The block is read a page at a time, each page from its chip with a sequential read.
+*
+* @param[in]	volumeAddress	The address in the volume to start reading from
+* @param[out]	data			Buffer for the bytes read
+* @param[in]	length			The number of bytes to read
+*
+* @return	1 = Success; 0 = A chip did not acknowledge
+************************************************************************/
+uint8_t EEPROMVolume_read(uint32_t volumeAddress, uint8_t *data, uint16_t length)
+{
+	uint8_t returnResult = 1;
+	uint8_t chip;
+	uint16_t chipPage;
+	uint8_t pageOffset = volumeAddress & (EEPROM_PAGE_SIZE - 1);
+	uint16_t pageLength;
+	
+	EEPROMVolume_locate(volumeAddress, &chip, &chipPage);
+	
+	while (returnResult && (length > 0))
+	{
+		//Read up to the end of the current page - the next page is on the next chip
+		pageLength = EEPROM_PAGE_SIZE - pageOffset;
+		if (pageLength > length)
+		{
+			pageLength = length;
+		}
+		
+		returnResult = EEPROM_readBlock(EEPROM_VOLUME_CHIP_ADDRESS(chip), (chipPage * EEPROM_PAGE_SIZE) + pageOffset, data, pageLength);
+		
+		data += pageLength;
+		length -= pageLength;
+		pageOffset = 0;
+		
+		chip++;
+		if (chip >= EEPROM_VOLUME_CHIPS)
+		{
+			chip = 0;
+			chipPage++;
+		}
+	}
+	
+	return returnResult;
+}
+
+
+
+/**
+* @brief	Wait for all chips in the volume to finish their write cycles
+*
+* @details	Use before power down, or before accessing the chips other than through the volume.
+*
+* @return	1 = All chips ready; 0 = A chip timed out
+************************************************************************/
+uint8_t EEPROMVolume_waitReady(void)
+{
+	uint8_t isReady = 1;
+	uint8_t chip;
+	
+	for (chip = 0; chip < EEPROM_VOLUME_CHIPS; chip++)
+	{
+		if (!EEPROM_waitReady(EEPROM_VOLUME_CHIP_ADDRESS(chip)))
+		{
+			isReady = 0;
+		}
+	}
+	
+	return isReady;
+}
@@ -0,0 +1,48 @@
+/*
+ * @file	EEPROMVolume.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef EEPROMVOLUME_H_
+#define EEPROMVOLUME_H_
+
+#include <avr/io.h>
+#include "EEPROM.h"
+
+#ifndef EEPROM_VOLUME_CHIPS
+#define EEPROM_VOLUME_CHIPS		1	//Number of EEPROM chips in the volume (1-8), all of the part set by EEPROM_PART
+#endif
+
+#ifndef EEPROM_VOLUME_BASE_ADDRESS
+#define EEPROM_VOLUME_BASE_ADDRESS	0b10100110	//I2C address of the first chip (default: the Toadstool 24LC Cap).
+												//Chip n has A2-A0 = the first chip's A2-A0 + n
+#endif
+
+#define EEPROM_VOLUME_CAPACITY	(EEPROM_CAPACITY * EEPROM_VOLUME_CHIPS)	//Size of the volume in bytes
+
+#if (EEPROM_VOLUME_CHIPS < 1) || (EEPROM_VOLUME_CHIPS > 8)
+#error "EEPROM_VOLUME_CHIPS must be between 1 and 8"
+#endif
+
+#if (EEPROM_VOLUME_BASE_ADDRESS & (((EEPROM_VOLUME_CHIPS - 1) | ((EEPROM_VOLUME_CHIPS - 1) >> 1) | ((EEPROM_VOLUME_CHIPS - 1) >> 2)) << 1)) != 0
+#error "EEPROM_VOLUME_BASE_ADDRESS must have zeros in the A2-A0 bits used to number the chips (eg. 0b10100000 for 8 chips)"
+#endif
+
+#if (EEPROM_VOLUME_CHIPS > 1) && (EEPROM_BLOCK_BITS > 0)
+#error "Parts using block select bits (24LC04B-24LC16B) have no A0-A2 pins, so only one can be on the bus"
+#endif
+
+
+uint8_t EEPROMVolume_write(uint32_t volumeAddress, const uint8_t *data, uint16_t length);
+uint8_t EEPROMVolume_read(uint32_t volumeAddress, uint8_t *data, uint16_t length);
+uint8_t EEPROMVolume_waitReady(void);
+
+
+
+#endif /* EEPROMVOLUME_H_ */
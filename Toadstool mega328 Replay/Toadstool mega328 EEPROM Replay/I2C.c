@@ -9,28 +9,29 @@
  */ 
 
 
+#include <avr/interrupt.h>
 #include "I2C.h"
 
+#define I2C_TWCR_NEXT	((1<<TWINT)|(1<<TWEN)|(1<<TWIE))	//Clear the Interrupt Flag, keep TWI and TWI interrupt enabled
+
+static volatile uint8_t I2C_isClaimed = 0;	//1 = A blocking transfer owns the bus, from I2C_sendStart until I2C_sendStop
+
 /**
 * @brief	Initialise the TWI
 *
-* @details	This routine initialises the TWI by: calculating Bit-rate, setting pre-scaler & bit-rate
+* @details	This routine initialises the TWI by setting pre-scaler & bit-rate.
+*			These are calculated at compile time from F_CPU and I2C_SCL_HZ (see I2C.h).
+*			The speed actually achieved is I2C_SCL_ACTUAL_HZ.
 *
-* @param[in]	I2C_kHz	The I2C bus speed in kHz (eg. 100 = 100kHz)
-* 
 * @return	none
 ************************************************************************/
-void I2C_init(uint8_t I2C_kHz)
+void I2C_init(void)
 {
-	uint8_t bitRate;
-	volatile uint16_t I2C_Hz = (unsigned long)I2C_kHz * 1000UL;
-	
-	bitRate = (F_CPU / (I2C_Hz * 2 * I2C_PRESCALER)) - (16 / (2 * I2C_PRESCALER) );	//Calculate bit-rate
 	
 	TWSR &= ~((1<<TWPS0)|(1<<TWPS1));		//Clear the pre-scaler
 	TWSR |= I2C_PRESCALER_BIT;				//Set the new pre-scaler
 	
-	TWBR = bitRate;	//Set the bit rate
+	TWBR = I2C_TWBR_VALUE;	//Set the bit rate
 	
 }
 
@@ -39,14 +40,30 @@ void I2C_init(uint8_t I2C_kHz)
 /**
 * @brief	Send a TWI Start Condition
 *
-* @details	This function enables the TWI and sends a Start Condition
+* @details	This function enables the TWI and sends a Start Condition.
+*			Waits for any transactions queued with I2C_queue to finish first, then claims the bus
+*			until I2C_sendStop so that a transaction queued from an interrupt can't start mid-transfer.
+*			The idle check and the claim are done with interrupts disabled, so nothing can be queued between them.
+*			A repeated START keeps the claim.
 *
 * @return	the result of the operation - the TWI Status bits from TWI Status Register
 ************************************************************************/
 uint8_t I2C_sendStart(void)
 {
+	uint8_t sreg = SREG;
+	
+	cli();
+	
+	if (!I2C_isClaimed)
+	{
+		I2C_waitIdle();	//Don't interrupt the transaction engine - it is stepped from here while interrupts are off
+		I2C_isClaimed = 1;
+	}
+	
 	TWCR = (1<<TWINT)|(1<<TWSTA)|(1<<TWEN); //Clear the Interrupt Flag, Set Start bit, Enable TWI
 	
+	SREG = sreg;
+	
 	I2C_waitComplete();	//Wait for transmission to complete
 		
 	return TW_STATUS;	//Success
@@ -58,13 +75,29 @@ uint8_t I2C_sendStart(void)
 /**
 * @brief	Send a TWI Stop Condition
 *
-* @details	This function sends a Stop Condition and clears the TWI Interrupt Flag
+* @details	This function sends a Stop Condition and clears the TWI Interrupt Flag.
+*			Releases the bus claimed by I2C_sendStart, and starts any transaction queued in the meantime.
 *
 * @return	none
 ************************************************************************/
 void I2C_sendStop(void)
 {
-	TWCR = (1<<TWINT)|(1<<TWSTO)|(1<<TWEN); //Clear the Interrupt Flag, Set Stop bit, Enable TWI
+	uint8_t sreg = SREG;
+	
+	cli();	//The TWI interrupt also updates the queue
+	
+	I2C_isClaimed = 0;
+	
+	if (I2C_isBusy())
+	{
+		TWCR = I2C_TWCR_NEXT | (1<<TWSTO) | (1<<TWSTA);	//STOP, then START for the queued transaction
+	}
+	else
+	{
+		TWCR = (1<<TWINT)|(1<<TWSTO)|(1<<TWEN); //Clear the Interrupt Flag, Set Stop bit, Enable TWI
+	}
+	
+	SREG = sreg;
 }
 
 
@@ -144,3 +177,372 @@ void I2C_waitComplete(void)
 	
 }
 
+
+
+/**
+* @brief	Write a buffer to a device in a single transaction
+*
+* @details	Sends START, the device address with WRITE, the prefix bytes (eg. the memory or register
+*			address) and then streams all data bytes, before sending STOP.
+*
+* @param[in]	deviceAddress	The I2C address of the device
+* @param[in]	prefix			Bytes to send before the data (may be NULL if prefixLength is 0)
+* @param[in]	prefixLength	The number of prefix bytes
+* @param[in]	data			The bytes to write
+* @param[in]	dataLength		The number of data bytes
+*
+* @return	1 = Success; 0 = A byte was not acknowledged
+************************************************************************/
+uint8_t I2C_writeBuffer(uint8_t deviceAddress, const uint8_t *prefix, uint8_t prefixLength, const uint8_t *data, uint16_t dataLength)
+{
+	uint8_t isAck;
+	
+	I2C_sendStart();
+	
+	//Send the device Address with WRITE - not ACKed if device not present or busy
+	isAck = (I2C_send(deviceAddress|TW_WRITE) == TW_MT_SLA_ACK);
+	
+	//Send the prefix
+	while (isAck && (prefixLength > 0))
+	{
+		isAck = (I2C_send(*prefix++) == TW_MT_DATA_ACK);
+		prefixLength--;
+	}
+	
+	//Stream the data
+	while (isAck && (dataLength > 0))
+	{
+		isAck = (I2C_send(*data++) == TW_MT_DATA_ACK);
+		dataLength--;
+	}
+	
+	I2C_sendStop();
+	
+	return isAck;
+}
+
+
+
+/**
+* @brief	Read a buffer from a device in a single transaction
+*
+* @details	Sends START, the device address with WRITE and the prefix bytes (eg. the memory or register
+*			address), then a repeated START and the device address with READ.  The data bytes are then
+*			streamed, sending ACK for all but the last byte, before sending STOP.
+*			If prefixLength is 0 the write phase is skipped, and the device's current address is read.
+*
+* @param[in]	deviceAddress	The I2C address of the device
+* @param[in]	prefix			Bytes to send before reading (may be NULL if prefixLength is 0)
+* @param[in]	prefixLength	The number of prefix bytes
+* @param[out]	data			Buffer for the bytes read
+* @param[in]	dataLength		The number of bytes to read
+*
+* @return	1 = Success; 0 = A byte was not acknowledged
+************************************************************************/
+uint8_t I2C_readBuffer(uint8_t deviceAddress, const uint8_t *prefix, uint8_t prefixLength, uint8_t *data, uint16_t dataLength)
+{
+	uint8_t isAck = 1;
+	
+	I2C_sendStart();
+	
+	if (prefixLength > 0)
+	{
+		//Send the device Address with WRITE - we need to write in order to specify the address to read from
+		isAck = (I2C_send(deviceAddress|TW_WRITE) == TW_MT_SLA_ACK);
+		
+		while (isAck && (prefixLength > 0))
+		{
+			isAck = (I2C_send(*prefix++) == TW_MT_DATA_ACK);
+			prefixLength--;
+		}
+		
+		I2C_sendStart();	//Send RESTART Condition - now we read from the address
+	}
+	
+	//Send the device Address with READ
+	if (isAck)
+	{
+		isAck = (I2C_send(deviceAddress|TW_READ) == TW_MR_SLA_ACK);
+	}
+	
+	//Stream the data, sending ACK for every byte except the last (No ACK means we're done reading)
+	while (isAck && (dataLength > 0))
+	{
+		dataLength--;
+		*data++ = I2C_read(dataLength > 0);
+	}
+	
+	I2C_sendStop();
+	
+	return isAck;
+}
+
+
+
+/**
+* @brief	Poll a device until it acknowledges its address
+*
+* @details	Sends START and the device address with WRITE.  If the device does not ACK, a repeated START
+*			and the address are sent again, until the device ACKs or maxPolls attempts have been made.
+*			A STOP is then sent.  Used to detect the end of an EEPROM's internal write cycle.
+*
+* @param[in]	deviceAddress	The I2C address of the device
+* @param[in]	maxPolls		The maximum number of times to send the address (1 or more)
+*
+* @return	1 = Device acknowledged; 0 = Timed out
+************************************************************************/
+uint8_t I2C_pollAck(uint8_t deviceAddress, uint16_t maxPolls)
+{
+	uint8_t isAck;
+	
+	do
+	{
+		I2C_sendStart();	//START, or repeated START if the device did not ACK last time
+		isAck = (I2C_send(deviceAddress|TW_WRITE) == TW_MT_SLA_ACK);
+		maxPolls--;
+	} while (!isAck && (maxPolls > 0));
+	
+	I2C_sendStop();
+	
+	return isAck;
+}
+
+
+
+/**********************************
+*  Interrupt-driven transaction engine
+***********************************/
+
+//Transactions waiting for the bus.  The one at I2C_queueTail is the one currently on the bus.
+static I2C_transaction * volatile I2C_queueList[I2C_QUEUE_SIZE];
+static volatile uint8_t I2C_queueHead = 0;	//Next free slot in the queue
+static volatile uint8_t I2C_queueTail = 0;	//Transaction currently being processed
+static uint16_t I2C_byteCount;				//Bytes transferred so far in the current phase (prefix+write, or read)
+
+static void I2C_step(void);
+
+
+/**
+* @brief	Queue a transaction for the interrupt-driven engine
+*
+* @details	Adds the transaction to the queue and, if the bus is idle, sends a START to begin processing.
+*			The transaction runs entirely from the TWI interrupt: START, SLA+W, prefix bytes, write bytes,
+*			then (if readLength > 0) a repeated START, SLA+R and the read bytes, then STOP.
+*			If there is nothing to write, the SLA+W phase is skipped and a current address read is done.
+*			If there is nothing to read or write, only SLA+W is sent - useful to check a device is ready.
+*			The transaction (and its buffers) must stay valid until status is no longer I2C_TXN_PENDING.
+*			The transaction is processed while interrupts are enabled, or by I2C_waitIdle.
+*			If a blocking transfer has claimed the bus, the START is sent by I2C_sendStop instead.
+*
+* @param[in]	transaction	The transaction to queue
+*
+* @return	1 = Queued; 0 = Queue full
+************************************************************************/
+uint8_t I2C_queue(I2C_transaction *transaction)
+{
+	uint8_t sreg = SREG;
+	uint8_t head;
+	uint8_t nextHead;
+	
+	cli();	//The TWI interrupt also updates the queue
+	
+	head = I2C_queueHead;
+	nextHead = (head + 1) & (I2C_QUEUE_SIZE - 1);
+	
+	if (nextHead == I2C_queueTail)	//Queue is full
+	{
+		SREG = sreg;
+		return 0;
+	}
+	
+	transaction->status = I2C_TXN_PENDING;
+	I2C_queueList[head] = transaction;
+	I2C_queueHead = nextHead;
+	
+	if ((head == I2C_queueTail) && !I2C_isClaimed)	//Engine was idle, so start this transaction now
+	{
+		TWCR = I2C_TWCR_NEXT | (1<<TWSTA);	//Send START
+	}
+	
+	SREG = sreg;
+	return 1;
+}
+
+
+
+/**
+* @brief	Check whether the transaction engine is using the bus
+*
+* @return	1 = Transactions are queued or in progress; 0 = Idle
+************************************************************************/
+uint8_t I2C_isBusy(void)
+{
+	return (I2C_queueHead != I2C_queueTail);
+}
+
+
+
+/**
+* @brief	Wait for all queued transactions to complete
+*
+* @details	If interrupts are disabled the TWI interrupt can't run, so the engine is stepped from here
+*			instead each time TWINT is set.  Callbacks are then called from here too.
+*
+* @return	none
+************************************************************************/
+void I2C_waitIdle(void)
+{
+	while (I2C_isBusy())
+	{
+		if (!(SREG & (1<<SREG_I)) && (TWCR & (1<<TWINT)))
+		{
+			I2C_step();
+		}
+	}
+}
+
+
+
+/**
+* @brief	Complete the current transaction and move onto the next one
+*
+* @details	Called from the TWI interrupt.  Records the status, calls the callback and then
+*			either sends STOP followed by START for the next transaction, or STOP and releases the bus.
+*
+* @param[in]	status	The final status of the transaction (I2C_TXN_xxx)
+*
+* @return	none
+************************************************************************/
+static void I2C_finish(uint8_t status)
+{
+	I2C_transaction *transaction = I2C_queueList[I2C_queueTail];
+	
+	transaction->status = status;
+	if (transaction->callback != NULL)
+	{
+		transaction->callback(transaction);	//May queue another transaction
+	}
+	
+	//Only remove from the queue after the callback, so that a transaction queued by the callback
+	//does not see an idle engine and send its own START
+	I2C_queueTail = (I2C_queueTail + 1) & (I2C_QUEUE_SIZE - 1);
+	
+	if (I2C_queueHead != I2C_queueTail)
+	{
+		TWCR = I2C_TWCR_NEXT | (1<<TWSTO) | (1<<TWSTA);	//STOP, then START for the next transaction
+	}
+	else
+	{
+		TWCR = (1<<TWINT) | (1<<TWSTO) | (1<<TWEN);	//STOP, and leave the TWI interrupt disabled
+	}
+}
+
+
+
+/**
+* @brief	Step the current transaction through its states
+*
+* @details	Called from the TWI interrupt, or from I2C_waitIdle when interrupts are disabled,
+*			each time TWINT is set.  The next step depends on the TWI status code.
+*
+* @return	none
+************************************************************************/
+static void I2C_step(void)
+{
+	I2C_transaction *transaction = I2C_queueList[I2C_queueTail];
+	uint16_t writeTotal = transaction->prefixLength + transaction->writeLength;
+	
+	switch (TW_STATUS)
+	{
+		case TW_START:
+			I2C_byteCount = 0;
+			if ((writeTotal > 0) || (transaction->readLength == 0))
+			{
+				TWDR = transaction->deviceAddress | TW_WRITE;
+			}
+			else
+			{
+				TWDR = transaction->deviceAddress | TW_READ;	//Nothing to write - current address read
+			}
+			TWCR = I2C_TWCR_NEXT;
+			break;
+		
+		case TW_REP_START:
+			I2C_byteCount = 0;
+			TWDR = transaction->deviceAddress | TW_READ;
+			TWCR = I2C_TWCR_NEXT;
+			break;
+		
+		case TW_MT_SLA_ACK:
+		case TW_MT_DATA_ACK:
+			if (I2C_byteCount < transaction->prefixLength)	//Still sending the prefix
+			{
+				TWDR = transaction->prefix[I2C_byteCount];
+				I2C_byteCount++;
+				TWCR = I2C_TWCR_NEXT;
+			}
+			else if (I2C_byteCount < writeTotal)	//Sending the write data
+			{
+				TWDR = transaction->writeData[I2C_byteCount - transaction->prefixLength];
+				I2C_byteCount++;
+				TWCR = I2C_TWCR_NEXT;
+			}
+			else if (transaction->readLength > 0)	//Writes finished, now read
+			{
+				TWCR = I2C_TWCR_NEXT | (1<<TWSTA);	//Send repeated START
+			}
+			else
+			{
+				I2C_finish(I2C_TXN_DONE);
+			}
+			break;
+		
+		case TW_MR_DATA_ACK:
+			transaction->readData[I2C_byteCount] = TWDR;
+			I2C_byteCount++;
+			//Fall through to request the next byte
+		
+		case TW_MR_SLA_ACK:
+			if ((I2C_byteCount + 1) < transaction->readLength)
+			{
+				TWCR = I2C_TWCR_NEXT | (1<<TWEA);	//More to come - ACK the next byte
+			}
+			else
+			{
+				TWCR = I2C_TWCR_NEXT;	//Last byte - NACK it
+			}
+			break;
+		
+		case TW_MR_DATA_NACK:
+			transaction->readData[I2C_byteCount] = TWDR;
+			I2C_finish(I2C_TXN_DONE);
+			break;
+		
+		case TW_MT_SLA_NACK:
+		case TW_MR_SLA_NACK:
+			I2C_finish(I2C_TXN_NACK);	//Device not present, or busy (eg. EEPROM write cycle)
+			break;
+		
+		case TW_MT_ARB_LOST:
+			TWCR = I2C_TWCR_NEXT | (1<<TWSTA);	//Another master won the bus - START again once it is free
+			break;
+		
+		default:	//Data NACKed, or bus error
+			I2C_finish(I2C_TXN_ERROR);
+			break;
+	}
+}
+
+
+
+/**
+* @brief	Interrupt Handler for the TWI
+*
+* @details	Not called from user code.
+*
+* @return	none
+************************************************************************/
+ISR(TWI_vect)
+{
+	I2C_step();
+}
@@ -0,0 +1,101 @@
+/*
+ * @file	LEDPattern.c
+ *
+ *  Shows patterns on an LED without blocking
+ *
+ *  A pattern is a list of steps in flash.  LEDPattern_start shows the first step straight away, and a
+ *  timer interrupt calls LEDPattern_tick to move through the rest - so the main loop carries on while the
+ *  pattern is shown.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "LEDPattern.h"
+
+
+static const LEDPattern_step *volatile currentStep = 0;	//Step being shown, or 0 once the pattern has finished
+static volatile uint8_t ticksLeft;	//Ticks until the next step
+
+
+
+/**
+* @brief	Show a step of the pattern
+*
+* @param[in]	step	Step to show (in flash)
+*
+* @return	none
+************************************************************************/
+static void LEDPattern_show(const LEDPattern_step *step)
+{
+	if (pgm_read_byte(&step->level))
+	{
+		LEDPATTERN_PORT |= (1<<LEDPATTERN_PIN);	//Turn the LED on
+	}
+	else
+	{
+		LEDPATTERN_PORT &= ~(1<<LEDPATTERN_PIN);	//Turn the LED off
+	}
+	
+	ticksLeft = pgm_read_byte(&step->ticks);
+	currentStep = (ticksLeft == LEDPATTERN_HOLD) ? 0 : step;	//Last step: the pattern has finished
+}
+
+
+
+/**
+* @brief	Start showing a pattern
+*
+* @details	Replaces any pattern already being shown.
+*
+* @param[in]	pattern		Steps of the pattern (in flash), ending with a step of duration LEDPATTERN_HOLD
+*
+* @return	none
+************************************************************************/
+void LEDPattern_start(const LEDPattern_step *pattern)
+{
+	uint8_t sreg = SREG;
+	
+	cli();	//Don't let the tick move on part-way through
+	LEDPattern_show(pattern);
+	SREG = sreg;
+}
+
+
+
+/**
+* @brief	Move the pattern on by one tick
+*
+* @details	Call from a timer interrupt every LEDPATTERN_TICK_MS.
+*
+* @return	none
+************************************************************************/
+void LEDPattern_tick(void)
+{
+	const LEDPattern_step *step = currentStep;
+	
+	if (step == 0)
+	{
+		return;	//No pattern being shown
+	}
+	
+	if (--ticksLeft == 0)
+	{
+		LEDPattern_show(step + 1);
+	}
+}
+
+
+
+/**
+* @brief	Check whether a pattern is being shown
+*
+* @return	1 = Pattern being shown; 0 = Finished (the LED holds the level of the last step)
+************************************************************************/
+uint8_t LEDPattern_isBusy(void)
+{
+	return (currentStep != 0);
+}
@@ -0,0 +1,53 @@
+/*
+ * @file	LEDPattern.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef LEDPATTERN_H_
+#define LEDPATTERN_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#ifndef LEDPATTERN_PORT
+#define LEDPATTERN_PORT		PORTB	//Port of the LED.  The pin must already be an output
+#endif
+
+#ifndef LEDPATTERN_PIN
+#define LEDPATTERN_PIN		PB1		//Pin of the LED
+#endif
+
+#ifndef LEDPATTERN_TICK_MS
+#define LEDPATTERN_TICK_MS	50		//Interval between calls to LEDPattern_tick
+#endif
+
+#define LEDPATTERN_MS(ms)	(uint8_t)((ms) / LEDPATTERN_TICK_MS)	//Duration of a step, in ticks.  No more than 255 ticks
+
+#define LEDPATTERN_HOLD		0		//Duration of the last step of a pattern: the LED holds its level
+
+
+/**
+* One step of a pattern: the LED is set to the level for the duration.
+* A pattern is an array of steps in flash (PROGMEM), ending with a step of duration LEDPATTERN_HOLD
+*/
+typedef struct
+{
+	uint8_t level;	//1 = LED on; 0 = LED off
+	uint8_t ticks;	//Duration in ticks (see LEDPATTERN_MS), or LEDPATTERN_HOLD for the last step
+} LEDPattern_step;
+
+
+void LEDPattern_start(const LEDPattern_step *pattern);
+void LEDPattern_tick(void);
+uint8_t LEDPattern_isBusy(void);
+
+
+
+#endif /* LEDPATTERN_H_ */
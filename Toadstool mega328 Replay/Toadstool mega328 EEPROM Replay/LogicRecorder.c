@@ -0,0 +1,253 @@
+/*
+ * @file	LogicRecorder.c
+ *
+ *  Records up to 8 digital inputs (the pins of one port) at LOGIC_SAMPLE_HZ, and replays them onto
+ *  the same pins as outputs
+ *
+ *  Timer2 paces the samples.  When recording, its interrupt reads the port into a ring buffer, and the
+ *  main loop moves the samples into a page buffer, writing each full page to the EEPROM volume with one
+ *  page write.  When replaying, the main loop reads the recording into the ring buffer, and the interrupt
+ *  writes one sample to the port each time.  So the timing of the samples does not depend on the I2C bus.
+ *
+ *  Samples are stored sample-major: one byte per sample, holding all the channels, in whole pages
+ *  (see PageStream.c).  At 1kHz, that is 1000 bytes/sec, well within the rate the EEPROM can write pages.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "LogicRecorder.h"
+
+
+static uint8_t logicBuffer[LOGIC_RING_SIZE];	//Storage for logicRing
+static uint8_t pageBuffer[EEPROM_PAGE_SIZE];	//Page being filled when recording
+static uint8_t pageFill;			//Bytes in pageBuffer
+static PageStream logicStream;		//The recording in the EEPROM volume
+static volatile uint8_t isRecording;	//1 = Timer2 interrupt records, 0 = Timer2 interrupt replays
+
+RingBuffer logicRing;
+volatile uint16_t logicUnderruns = 0;
+
+
+
+/**
+* @brief	Start Timer2 interrupting at LOGIC_SAMPLE_HZ
+*
+* @return	none
+************************************************************************/
+static void LogicRecorder_startTimer(void)
+{
+	TIMSK2 &= ~(1<<OCIE2A);				//Disable interrupts on timer
+	TCCR2A = (1<<WGM21);				//Set to CTC (compare) mode
+	TCCR2B = (1<<CS22);					//Set prescaler to 64
+	OCR2A = LOGIC_TIMER2_TOP;			//Crystal = 16MHz; Prescaler = 64; counts per sec = 250,000; Interval = 1ms
+	TCNT2 = 0;
+	TIFR2 = (1<<OCF2A);
+	TIMSK2 |= (1<<OCIE2A);				//Enable interrupts on Compare
+}
+
+
+
+/**
+* @brief	Stop Timer2
+*
+* @return	none
+************************************************************************/
+static void LogicRecorder_stopTimer(void)
+{
+	TIMSK2 &= ~(1<<OCIE2A);
+	TCCR2B = 0;	//Stop the clock
+}
+
+
+
+/**
+* @brief	Start recording
+*
+* @details	Sets the channels as inputs, and starts sampling them.
+*
+* @param[in]	startAddress	Volume address for the first page of the recording.  Must be the start of a page
+*
+* @return	none
+************************************************************************/
+void LogicRecorder_startRecord(uint32_t startAddress)
+{
+	LOGIC_DDR &= (uint8_t)~LOGIC_CHANNEL_MASK;	//Channels are inputs
+	LOGIC_PORT &= (uint8_t)~LOGIC_CHANNEL_MASK;	//No pull-ups: the inputs are driven by the circuit being recorded
+	
+	PageStream_startWrite(&logicStream, startAddress);
+	pageFill = 0;
+	
+	RingBuffer_init(&logicRing, logicBuffer, 1, LOGIC_RING_SIZE);
+	isRecording = 1;
+	LogicRecorder_startTimer();
+}
+
+
+
+/**
+* @brief	Move recorded samples to the EEPROM
+*
+* @details	Call from the main loop while recording.  Takes all the samples waiting as a batch, and writes
+*			each page as it fills.
+*
+* @return	1 = Recording; 0 = The volume is full, so the recording has stopped
+************************************************************************/
+uint8_t LogicRecorder_serviceRecord(void)
+{
+	uint8_t *samples;
+	uint8_t sampleCount;
+	
+	while ((sampleCount = RingBuffer_peek(&logicRing, (void **)&samples)) > 0)
+	{
+		if (PageStream_isFull(&logicStream))
+		{
+			LogicRecorder_stopTimer();	//Full
+			return 0;
+		}
+		
+		//Copy as many as fit in the page
+		if (sampleCount > (EEPROM_PAGE_SIZE - pageFill))
+		{
+			sampleCount = EEPROM_PAGE_SIZE - pageFill;
+		}
+		
+		memcpy(&pageBuffer[pageFill], samples, sampleCount);
+		RingBuffer_release(&logicRing, sampleCount);
+		pageFill += sampleCount;
+		
+		if (pageFill == EEPROM_PAGE_SIZE)
+		{
+			//Page full: one page write, while the interrupt carries on filling the ring buffer
+			PageStream_writePage(&logicStream, pageBuffer);
+			pageFill = 0;
+		}
+	}
+	
+	return 1;
+}
+
+
+
+/**
+* @brief	Stop recording
+*
+* @details	Writes the samples waiting, and fills out the last page with the last sample.
+*
+* @return	Number of pages in the recording
+************************************************************************/
+uint16_t LogicRecorder_stopRecord(void)
+{
+	LogicRecorder_stopTimer();
+	
+	LogicRecorder_serviceRecord();
+	
+	return PageStream_finishWrite(&logicStream, pageBuffer, pageFill);
+}
+
+
+
+/**
+* @brief	Start replaying
+*
+* @details	Sets the channels as outputs, fills the ring buffer and starts the replay.
+*			The recording is replayed in a loop.  With no pages, the channels are left as inputs.
+*
+* @param[in]	startAddress	Volume address of the first page of the recording
+* @param[in]	pages			Number of pages in the recording
+*
+* @return	none
+************************************************************************/
+void LogicRecorder_startReplay(uint32_t startAddress, uint16_t pages)
+{
+	if (!PageStream_startRead(&logicStream, startAddress, pages))
+	{
+		return;	//Nothing to replay
+	}
+	
+	RingBuffer_init(&logicRing, logicBuffer, 1, LOGIC_RING_SIZE);
+	LogicRecorder_serviceReplay();	//Fill the ring buffer before the first sample
+	
+	LOGIC_DDR |= LOGIC_CHANNEL_MASK;	//Channels are outputs
+	
+	isRecording = 0;
+	LogicRecorder_startTimer();
+}
+
+
+
+/**
+* @brief	Read more of the recording into the ring buffer
+*
+* @details	Call from the main loop while replaying.  Reads LOGIC_READ_CHUNK samples at a time, while
+*			there is room, looping back to the start of the recording at the end.
+*
+* @return	none
+************************************************************************/
+void LogicRecorder_serviceReplay(void)
+{
+	uint8_t chunk[LOGIC_READ_CHUNK];
+	uint8_t iCount;
+	
+	if (!logicStream.isReading)
+	{
+		return;	//Not replaying
+	}
+	
+	while ((LOGIC_RING_SIZE - RingBuffer_used(&logicRing)) >= LOGIC_READ_CHUNK)
+	{
+		PageStream_read(&logicStream, chunk, LOGIC_READ_CHUNK);
+		
+		for (iCount = 0; iCount < LOGIC_READ_CHUNK; iCount++)
+		{
+			RingBuffer_put(&logicRing, &chunk[iCount]);
+		}
+	}
+}
+
+
+
+/**
+* @brief	Stop replaying
+*
+* @details	Sets the channels back to inputs.
+*
+* @return	none
+************************************************************************/
+void LogicRecorder_stopReplay(void)
+{
+	LogicRecorder_stopTimer();
+	LOGIC_DDR &= (uint8_t)~LOGIC_CHANNEL_MASK;
+	PageStream_stopRead(&logicStream);
+}
+
+
+
+/**
+* @brief	Interrupt Handler for Timer2A Compare
+*
+* @details	Not called from user code.  Called at LOGIC_SAMPLE_HZ to take or play one sample.
+*
+* @return	none
+************************************************************************/
+ISR(TIMER2_COMPA_vect)
+{
+	uint8_t sample;
+	
+	if (isRecording)
+	{
+		sample = LOGIC_PIN & LOGIC_CHANNEL_MASK;
+		RingBuffer_put(&logicRing, &sample);	//If full, the sample is dropped and counted in logicRing.overflows
+	}
+	else if (RingBuffer_get(&logicRing, &sample))
+	{
+		LOGIC_PORT = (LOGIC_PORT & (uint8_t)~LOGIC_CHANNEL_MASK) | sample;
+	}
+	else
+	{
+		logicUnderruns++;	//Main loop hasn't read the next sample in time - hold the outputs
+	}
+}
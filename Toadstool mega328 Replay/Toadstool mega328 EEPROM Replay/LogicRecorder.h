@@ -0,0 +1,60 @@
+/*
+ * @file	LogicRecorder.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef LOGICRECORDER_H_
+#define LOGICRECORDER_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "PageStream.h"
+#include "RingBuffer.h"
+
+#ifndef LOGIC_SAMPLE_HZ
+#define LOGIC_SAMPLE_HZ		1000	//Samples per second, for all channels
+#endif
+
+//Port recorded from, and replayed onto.  PORTD is free on the Toadstool mega328 in this project
+//(the UART on PD0/PD1 is not used)
+#ifndef LOGIC_PORT
+#define LOGIC_PORT			PORTD
+#define LOGIC_PIN			PIND
+#define LOGIC_DDR			DDRD
+#endif
+
+#ifndef LOGIC_CHANNEL_MASK
+#define LOGIC_CHANNEL_MASK	0xFF	//Pins of the port used as channels (1 bit per channel)
+#endif
+
+#define LOGIC_RING_SIZE		128		//Samples buffered between the Timer2 interrupt and the main loop: 128ms at 1kHz
+#define LOGIC_READ_CHUNK	((EEPROM_PAGE_SIZE < 32) ? EEPROM_PAGE_SIZE : 32)	//Samples read from the EEPROM at a time during replay.  Divides a page exactly
+
+//Timer2 runs at F_CPU / 64, and Compare A sets the sample rate
+#define LOGIC_TIMER2_TOP	((F_CPU / 64UL / LOGIC_SAMPLE_HZ) - 1)
+
+#if (LOGIC_TIMER2_TOP > 255) || (LOGIC_TIMER2_TOP < 1)
+#error "LOGIC_SAMPLE_HZ is out of range for Timer2 at F_CPU / 64"
+#endif
+
+
+extern volatile uint16_t logicUnderruns;	//Replay samples missed because the main loop fell behind
+extern RingBuffer logicRing;				//logicRing.overflows: recorded samples lost because the main loop fell behind
+
+
+void LogicRecorder_startRecord(uint32_t firstAddress);
+uint8_t LogicRecorder_serviceRecord(void);
+uint16_t LogicRecorder_stopRecord(void);
+void LogicRecorder_startReplay(uint32_t firstAddress, uint16_t pageCount);
+void LogicRecorder_serviceReplay(void);
+void LogicRecorder_stopReplay(void);
+
+
+
+#endif /* LOGICRECORDER_H_ */
@@ -0,0 +1,163 @@
+/*
+ * @file	PageStream.c
+ *
+ *  Writes a recording to the EEPROM volume a page at a time, and reads it back in a loop
+ *
+ *  Shared by the Logic and Analog Recorders, which differ only in how they take and play their samples.
+ *  A recording is a whole number of pages, so each page is written with a single page write - the last
+ *  page is filled out by repeating its last byte.  Its length is the number of pages.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "PageStream.h"
+
+
+
+/**
+* @brief	Start writing a recording
+*
+* @param[out]	stream			The recording
+* @param[in]	firstAddress	Volume address for the first page.  Must be the start of a page
+*
+* @return	none
+************************************************************************/
+void PageStream_startWrite(PageStream *stream, uint32_t firstAddress)
+{
+	stream->firstAddress = firstAddress;
+	stream->nextAddress = firstAddress;
+	stream->pageCount = 0;
+	stream->isReading = 0;
+}
+
+
+
+/**
+* @brief	Check whether there is room for another page
+*
+* @param[in]	stream	The recording
+*
+* @return	1 = The volume is full; 0 = Another page can be written
+************************************************************************/
+uint8_t PageStream_isFull(const PageStream *stream)
+{
+	return ((stream->nextAddress + EEPROM_PAGE_SIZE) > EEPROM_VOLUME_CAPACITY);
+}
+
+
+
+/**
+* @brief	Write the next page of the recording
+*
+* @details	One page write.  The chip's write cycle continues while the next page is filled.
+*			Check PageStream_isFull first.
+*
+* @param[in,out]	stream	The recording
+* @param[in]		page	EEPROM_PAGE_SIZE bytes to write
+*
+* @return	none
+************************************************************************/
+void PageStream_writePage(PageStream *stream, const uint8_t *page)
+{
+	EEPROMVolume_write(stream->nextAddress, page, EEPROM_PAGE_SIZE);
+	stream->nextAddress += EEPROM_PAGE_SIZE;
+	stream->pageCount++;
+}
+
+
+
+/**
+* @brief	Finish writing a recording
+*
+* @details	Fills out the part-filled last page by repeating its last byte, and writes it if there is room.
+*			Then waits for the chips to finish writing.
+*
+* @param[in,out]	stream	The recording
+* @param[in,out]	page	The last page (EEPROM_PAGE_SIZE bytes)
+* @param[in]		fill	Bytes already in the last page (0 = no part-filled page)
+*
+* @return	Number of pages in the recording
+************************************************************************/
+uint16_t PageStream_finishWrite(PageStream *stream, uint8_t *page, uint8_t fill)
+{
+	uint8_t lastByte;
+	
+	if ((fill > 0) && !PageStream_isFull(stream))
+	{
+		lastByte = page[fill - 1];
+		
+		while (fill < EEPROM_PAGE_SIZE)
+		{
+			page[fill++] = lastByte;
+		}
+		
+		PageStream_writePage(stream, page);
+	}
+	
+	EEPROMVolume_waitReady();
+	
+	return stream->pageCount;
+}
+
+
+
+/**
+* @brief	Start reading a recording
+*
+* @param[out]	stream			The recording
+* @param[in]	firstAddress	Volume address of the first page
+* @param[in]	pageCount		Number of pages in the recording
+*
+* @return	1 = Reading; 0 = No pages, so nothing to read
+************************************************************************/
+uint8_t PageStream_startRead(PageStream *stream, uint32_t firstAddress, uint16_t pageCount)
+{
+	stream->firstAddress = firstAddress;
+	stream->nextAddress = firstAddress;
+	stream->endAddress = firstAddress + ((uint32_t)pageCount * EEPROM_PAGE_SIZE);
+	stream->isReading = (pageCount > 0);
+	
+	return stream->isReading;
+}
+
+
+
+/**
+* @brief	Read the next bytes of the recording
+*
+* @details	Loops back to the start of the recording after the end.
+*
+* @param[in,out]	stream	The recording
+* @param[out]		data	Buffer for the bytes
+* @param[in]		length	Bytes to read.  Must divide EEPROM_PAGE_SIZE exactly, so a read never runs past the end
+*
+* @return	none
+************************************************************************/
+void PageStream_read(PageStream *stream, uint8_t *data, uint8_t length)
+{
+	EEPROMVolume_read(stream->nextAddress, data, length);
+	
+	stream->nextAddress += length;
+	if (stream->nextAddress >= stream->endAddress)
+	{
+		stream->nextAddress = stream->firstAddress;
+	}
+}
+
+
+
+/**
+* @brief	Stop reading a recording
+*
+* @param[out]	stream	The recording
+*
+* @return	none
+************************************************************************/
+void PageStream_stopRead(PageStream *stream)
+{
+	stream->isReading = 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * @file	PageStream.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef PAGESTREAM_H_
+#define PAGESTREAM_H_
+
+#include <avr/io.h>
+#include "EEPROM.h"
+#include "EEPROMVolume.h"
+
+
+/**
+* A recording held in whole pages of the EEPROM volume, written and read back in order
+*/
+typedef struct
+{
+	uint32_t firstAddress;	//Volume address of the first page of the recording
+	uint32_t nextAddress;	//Volume address of the next page to write, or the next byte to read
+	uint32_t endAddress;	//Reading: volume address after the last page of the recording
+	uint16_t pageCount;		//Writing: number of pages written
+	uint8_t isReading;		//1 = Being read (replayed)
+} PageStream;
+
+
+void PageStream_startWrite(PageStream *stream, uint32_t firstAddress);
+uint8_t PageStream_isFull(const PageStream *stream);
+void PageStream_writePage(PageStream *stream, const uint8_t *page);
+uint16_t PageStream_finishWrite(PageStream *stream, uint8_t *page, uint8_t fill);
+uint8_t PageStream_startRead(PageStream *stream, uint32_t firstAddress, uint16_t pageCount);
+void PageStream_read(PageStream *stream, uint8_t *data, uint8_t length);
+void PageStream_stopRead(PageStream *stream);
+
+
+
+#endif /* PAGESTREAM_H_ */
@@ -0,0 +1,204 @@
+/*
+ * @file	Prefetch.c
+ *
+ *  Read-ahead buffer for streaming a sequence of bytes from the EEPROM.
+ *
+ *  The sequence (firstAddress to lastAddress) is read in a loop.  Bytes are taken from a RAM buffer
+ *  with Prefetch_readByte, which never touches the I2C bus as long as Prefetch_service is called
+ *  between reads.  Prefetch_service tops up the buffer in the background, using the interrupt-driven
+ *  I2C transaction engine.  If the whole sequence fits in the buffer, it is read once by
+ *  Prefetch_start and there is no further I2C traffic.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "Prefetch.h"
+
+
+static uint8_t prefetchBuffer[PREFETCH_SIZE];	//Ring buffer of bytes read ahead
+static uint16_t prefetchDevice;		//I2C address of the EEPROM device
+static uint16_t prefetchFirst;		//First address of the sequence
+static uint16_t prefetchLast;		//Last address of the sequence
+static uint16_t fetchAddress;		//Next EEPROM address to fetch into the buffer
+static uint8_t fetchLength;			//Number of bytes being fetched by fetchTransaction
+static uint8_t isWholeCached;		//1 = The whole sequence is in the buffer
+static uint8_t cachedLength;		//Length of the sequence, if the whole sequence is in the buffer
+
+//Free-running counts of bytes put into and taken out of the buffer.  Each is only written by one side
+//(fillCount by the TWI interrupt, readCount by the main loop) so no locking is needed
+static volatile uint8_t fillCount;
+static uint8_t readCount;
+
+static I2C_transaction fetchTransaction;	//Background read, processed by the I2C transaction engine
+
+volatile uint16_t prefetchUnderruns = 0;	//Number of times Prefetch_readByte had to wait for the bus
+
+
+
+/**
+* @brief	Background read complete
+*
+* @details	Called from the TWI interrupt when fetchTransaction completes.  On success the bytes are
+*			made available to Prefetch_readByte.  On failure (eg. EEPROM busy) the read is retried by
+*			the next call to Prefetch_service.
+*
+* @param[in]	transaction	The completed transaction
+*
+* @return	none
+************************************************************************/
+static void Prefetch_fetchComplete(I2C_transaction *transaction)
+{
+	if (transaction->status == I2C_TXN_DONE)
+	{
+		fillCount += fetchLength;
+		
+		fetchAddress += fetchLength;
+		if (fetchAddress > prefetchLast)	//Reached the end of the sequence, so start from beginning
+		{
+			fetchAddress = prefetchFirst;
+		}
+	}
+}
+
+
+
+/**
+* @brief	Start streaming a sequence from the EEPROM
+*
+* @details	Fills the buffer from the start of the sequence, using a single (blocking) sequential read.
+*			If the whole sequence fits in the buffer it is cached, and no further reads are needed.
+*
+* @param[in]	deviceAddress	The I2C address of the EEPROM device
+* @param[in]	firstAddress	The first address of the sequence
+* @param[in]	lastAddress		The last address of the sequence
+*
+* @return	none
+************************************************************************/
+void Prefetch_start(uint16_t deviceAddress, uint16_t firstAddress, uint16_t lastAddress)
+{
+	uint16_t sequenceLength = lastAddress - firstAddress + 1;
+	
+	I2C_waitIdle();	//Let any background read of the previous sequence finish
+	
+	prefetchDevice = deviceAddress;
+	prefetchFirst = firstAddress;
+	prefetchLast = lastAddress;
+	readCount = 0;
+	fetchTransaction.callback = Prefetch_fetchComplete;
+	
+	if (sequenceLength <= PREFETCH_SIZE)	//Short sequence: cache it all now
+	{
+		isWholeCached = 1;
+		cachedLength = sequenceLength;
+		EEPROM_readBlock(deviceAddress, firstAddress, prefetchBuffer, sequenceLength);
+	}
+	else	//Long sequence: fill the buffer, and top it up in Prefetch_service
+	{
+		isWholeCached = 0;
+		EEPROM_readBlock(deviceAddress, firstAddress, prefetchBuffer, PREFETCH_SIZE);
+		fillCount = PREFETCH_SIZE;
+		fetchAddress = firstAddress + PREFETCH_SIZE;
+	}
+}
+
+
+
+/**
+* @brief	Read the next byte of the sequence
+*
+* @details	Takes the next byte from the RAM buffer, looping back to the start at the end of the sequence.
+*			Only waits for the I2C bus if the buffer has run dry (counted in prefetchUnderruns).
+*
+* @return	The next byte
+************************************************************************/
+uint8_t Prefetch_readByte(void)
+{
+	uint8_t readData;
+	
+	if (isWholeCached)
+	{
+		readData = prefetchBuffer[readCount];
+		readCount++;
+		if (readCount >= cachedLength)
+		{
+			readCount = 0;
+		}
+		return readData;
+	}
+	
+	if (fillCount == readCount)	//Buffer is empty - Prefetch_service has not been called often enough
+	{
+		prefetchUnderruns++;
+		do
+		{
+			Prefetch_service();
+			I2C_waitIdle();
+		} while (fillCount == readCount);
+	}
+	
+	readData = prefetchBuffer[readCount & (PREFETCH_SIZE - 1)];
+	readCount++;
+	
+	return readData;
+}
+
+
+
+/**
+* @brief	Check whether the buffer needs topping up
+*
+* @details	Prefetch_service has nothing to do while a read is in progress, or there is not enough room
+*			for another.  Safe to call with interrupts disabled - eg. to decide whether to sleep.
+*
+* @return	1 = Nothing to do; 0 = Prefetch_service would queue a read
+************************************************************************/
+uint8_t Prefetch_isIdle(void)
+{
+	if (isWholeCached || (fetchTransaction.status == I2C_TXN_PENDING))
+	{
+		return 1;
+	}
+	
+	return ((uint8_t)(PREFETCH_SIZE - (uint8_t)(fillCount - readCount)) < PREFETCH_CHUNK);	//Not enough room yet
+}
+
+
+
+/**
+* @brief	Top up the buffer in the background
+*
+* @details	Call regularly (eg. from the main loop between timer ticks).  When at least PREFETCH_CHUNK
+*			bytes of the buffer are free, and no read is in progress, queues a read of the next part
+*			of the sequence.  Returns immediately - the read is completed by the TWI interrupt.
+*
+* @return	none
+************************************************************************/
+void Prefetch_service(void)
+{
+	uint8_t fillIndex;
+	uint16_t length;
+	
+	if (Prefetch_isIdle())
+	{
+		return;
+	}
+	
+	fillIndex = fillCount & (PREFETCH_SIZE - 1);
+	
+	length = PREFETCH_CHUNK;
+	if (length > (PREFETCH_SIZE - fillIndex))	//Don't run past the end of the buffer
+	{
+		length = PREFETCH_SIZE - fillIndex;
+	}
+	if (length > (prefetchLast - fetchAddress + 1))	//Don't run past the end of the sequence
+	{
+		length = prefetchLast - fetchAddress + 1;
+	}
+	
+	fetchLength = length;
+	EEPROM_queueRead(&fetchTransaction, prefetchDevice, fetchAddress, &prefetchBuffer[fillIndex], length);
+}
@@ -0,0 +1,39 @@
+/*
+ * @file	Prefetch.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef PREFETCH_H_
+#define PREFETCH_H_
+
+#include <avr/io.h>
+#include "I2C.h"
+#include "EEPROM.h"
+
+#ifndef PREFETCH_SIZE
+#define PREFETCH_SIZE	32	//Size of the read-ahead buffer in bytes.  Must be a power of 2, and no more than 128
+#endif
+#define PREFETCH_CHUNK	(PREFETCH_SIZE / 2)	//Bytes fetched by each background read
+
+#if ((PREFETCH_SIZE & (PREFETCH_SIZE - 1)) != 0) || (PREFETCH_SIZE > 128)
+#error "PREFETCH_SIZE must be a power of 2, and no more than 128"
+#endif
+
+
+extern volatile uint16_t prefetchUnderruns;	//Number of times Prefetch_readByte had to wait for the bus
+
+
+void Prefetch_start(uint16_t deviceAddress, uint16_t firstAddress, uint16_t lastAddress);
+uint8_t Prefetch_readByte(void);
+void Prefetch_service(void);
+uint8_t Prefetch_isIdle(void);
+
+
+
+#endif /* PREFETCH_H_ */
@@ -0,0 +1,161 @@
+/*
+ * @file	RingBuffer.c
+ *
+ *  Lock-free ring buffer for passing data from an interrupt to the main loop (or the other way)
+ *
+ *  There must be only one producer (calling RingBuffer_put) and one consumer (calling RingBuffer_get,
+ *  or RingBuffer_peek and RingBuffer_release).  The producer only writes putCount, and the consumer only
+ *  writes getCount - each a single byte, so updated atomically - and an element is always stored before
+ *  putCount says it is there.  So neither side needs to disable interrupts.
+ *
+ *  If the buffer is full, RingBuffer_put drops the new element and counts it in overflows, so a
+ *  recording can be checked for lost data.
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "RingBuffer.h"
+
+
+
+/**
+* @brief	Initialise a ring buffer
+*
+* @param[out]	ring			The ring buffer
+* @param[in]	buffer			Storage for elementCount elements of elementSize bytes
+* @param[in]	elementSize		Size of each element in bytes
+* @param[in]	elementCount	Number of elements.  Must be a power of 2, and no more than 128
+*
+* @return	none
+************************************************************************/
+void RingBuffer_init(RingBuffer *ring, void *buffer, uint8_t elementSize, uint8_t elementCount)
+{
+	ring->buffer = buffer;
+	ring->elementSize = elementSize;
+	ring->elementCount = elementCount;
+	ring->putCount = 0;
+	ring->getCount = 0;
+	ring->overflows = 0;
+	ring->maxUsed = 0;
+}
+
+
+
+/**
+* @brief	Put an element into the ring buffer (producer)
+*
+* @param[in,out]	ring	The ring buffer
+* @param[in]		element	The element to copy in
+*
+* @return	1 = Success; 0 = Buffer full, element dropped
+************************************************************************/
+uint8_t RingBuffer_put(RingBuffer *ring, const void *element)
+{
+	uint8_t putCount = ring->putCount;
+	uint8_t used = putCount - ring->getCount;
+	
+	if (used >= ring->elementCount)
+	{
+		ring->overflows++;
+		return 0;
+	}
+	
+	memcpy(ring->buffer + ((putCount & (ring->elementCount - 1)) * ring->elementSize), element, ring->elementSize);
+	
+	ring->putCount = putCount + 1;	//Only now is the element available to the consumer
+	
+	if (used >= ring->maxUsed)
+	{
+		ring->maxUsed = used + 1;
+	}
+	
+	return 1;
+}
+
+
+
+/**
+* @brief	Take an element out of the ring buffer (consumer)
+*
+* @param[in,out]	ring	The ring buffer
+* @param[out]		element	Buffer to copy the element into
+*
+* @return	1 = Success; 0 = Buffer empty
+************************************************************************/
+uint8_t RingBuffer_get(RingBuffer *ring, void *element)
+{
+	uint8_t getCount = ring->getCount;
+	
+	if (getCount == ring->putCount)
+	{
+		return 0;
+	}
+	
+	memcpy(element, ring->buffer + ((getCount & (ring->elementCount - 1)) * ring->elementSize), ring->elementSize);
+	
+	ring->getCount = getCount + 1;	//Only now can the producer reuse the space
+	
+	return 1;
+}
+
+
+
+/**
+* @brief	Number of elements waiting in the ring buffer
+*
+* @param[in]	ring	The ring buffer
+*
+* @return	Number of elements
+************************************************************************/
+uint8_t RingBuffer_used(RingBuffer *ring)
+{
+	return ring->putCount - ring->getCount;
+}
+
+
+
+/**
+* @brief	Get the waiting elements in place, for handling as a batch (consumer)
+*
+* @details	Returns the elements that are stored one after another, up to the end of the buffer - call
+*			again after RingBuffer_release to get any that have wrapped around to the start.
+*			The elements stay in the buffer until RingBuffer_release.
+*
+* @param[in]	ring		The ring buffer
+* @param[out]	elements	Set to the first waiting element
+*
+* @return	Number of elements at *elements (0 = Buffer empty)
+************************************************************************/
+uint8_t RingBuffer_peek(RingBuffer *ring, void **elements)
+{
+	uint8_t first = ring->getCount & (ring->elementCount - 1);
+	uint8_t count = ring->putCount - ring->getCount;
+	
+	if (count > (ring->elementCount - first))
+	{
+		count = ring->elementCount - first;	//Stop at the end of the buffer
+	}
+	
+	*elements = ring->buffer + (first * ring->elementSize);
+	
+	return count;
+}
+
+
+
+/**
+* @brief	Release elements handled after RingBuffer_peek (consumer)
+*
+* @param[in,out]	ring	The ring buffer
+* @param[in]		count	Number of elements to release - no more than RingBuffer_peek returned
+*
+* @return	none
+************************************************************************/
+void RingBuffer_release(RingBuffer *ring, uint8_t count)
+{
+	ring->getCount += count;
+}
@@ -0,0 +1,43 @@
+/*
+ * @file	RingBuffer.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef RINGBUFFER_H_
+#define RINGBUFFER_H_
+
+#include <avr/io.h>
+#include <string.h>
+
+
+/**
+* A ring buffer of fixed-size elements, passed from one producer to one consumer
+*/
+typedef struct
+{
+	uint8_t *buffer;			//Storage for elementCount elements
+	uint8_t elementSize;		//Size of each element in bytes
+	uint8_t elementCount;		//Number of elements the buffer holds.  Must be a power of 2, and no more than 128
+	volatile uint8_t putCount;	//Elements put in so far (wraps around).  Only written by the producer
+	volatile uint8_t getCount;	//Elements taken out so far (wraps around).  Only written by the consumer
+	volatile uint16_t overflows;	//Elements dropped because the buffer was full
+	volatile uint8_t maxUsed;	//Most elements that have been waiting at once
+} RingBuffer;
+
+
+void RingBuffer_init(RingBuffer *ring, void *buffer, uint8_t elementSize, uint8_t elementCount);
+uint8_t RingBuffer_put(RingBuffer *ring, const void *element);
+uint8_t RingBuffer_get(RingBuffer *ring, void *element);
+uint8_t RingBuffer_used(RingBuffer *ring);
+uint8_t RingBuffer_peek(RingBuffer *ring, void **elements);
+void RingBuffer_release(RingBuffer *ring, uint8_t count);
+
+
+
+#endif /* RINGBUFFER_H_ */
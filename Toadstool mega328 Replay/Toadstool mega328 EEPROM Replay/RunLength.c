@@ -0,0 +1,246 @@
+/*
+ * @file	RunLength.c
+ *
+ *  Run-length encoding of a recording of on/off samples
+ *
+ *  A recording is stored as:
+ *		- One byte holding the level of the first sample (0 or 1)
+ *		- The length of each run of samples at the same level.  The level changes after every run
+ *		- A run length of 0 (RUNLENGTH_END) to mark the end of the recording
+ *
+ *  A "sample" is whatever unit of time the caller uses - a fixed sample interval, or the time between
+ *  edges in timer ticks.  Run lengths are variable-length encoded: 7 bits per byte, least significant
+ *  first, with bit 7 set on every byte except the last.  So a run of up to 127 samples takes one byte,
+ *  and a long hold costs only a few bytes however long it lasts.
+ *
+ *  The encoder and decoder both stream a run at a time, so neither needs the whole
+ *  recording in RAM.
+ *  The decoder loops back to the start when it reaches the end marker, so it expects the bytes after the
+ *  end marker to be the start of the recording again (as Prefetch_readByte provides).
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+#include "RunLength.h"
+
+
+static void (*encodeWriteByte)(uint8_t data);	//Destination for encoded bytes
+static uint8_t encodeLevel;			//Level of the current run
+static uint32_t encodeRun;			//Number of samples in the current run so far
+
+static uint8_t (*decodeReadByte)(void);	//Source of encoded bytes
+static uint8_t decodeLevel;			//Level of the current run
+static uint32_t decodeRemaining;	//Samples left in the current run
+static uint8_t isFirstRun;			//1 = Next run is the first of the recording, so keeps the starting level
+
+
+
+/**
+* @brief	Write a run length
+*
+* @param[in]	runLength	Number of samples in the run (or RUNLENGTH_END)
+*
+* @return	none
+************************************************************************/
+static void RunLength_writeRun(uint32_t runLength)
+{
+	while (runLength > 0x7F)
+	{
+		encodeWriteByte((uint8_t)(runLength & 0x7F) | 0x80);	//More bytes follow
+		runLength >>= 7;
+	}
+	
+	encodeWriteByte((uint8_t)runLength);
+}
+
+
+
+/**
+* @brief	Read a run length
+*
+* @details	Reads at most RUNLENGTH_MAX_RUN_BYTES bytes, so corrupt data can't stall the decoder.
+*
+* @return	Number of samples in the run (or RUNLENGTH_END)
+************************************************************************/
+static uint32_t RunLength_readRun(void)
+{
+	uint32_t runLength = 0;
+	uint8_t shift = 0;
+	uint8_t readByte;
+	
+	do
+	{
+		readByte = decodeReadByte();
+		runLength |= (uint32_t)(readByte & 0x7F) << shift;
+		shift += 7;
+	} while ((readByte & 0x80) && (shift < (7 * RUNLENGTH_MAX_RUN_BYTES)));
+	
+	return runLength;
+}
+
+
+
+/**
+* @brief	Start encoding a recording
+*
+* @param[in]	writeByte	Function called with each encoded byte, in order
+*
+* @return	none
+************************************************************************/
+void RunLength_startEncode(void (*writeByte)(uint8_t data))
+{
+	encodeWriteByte = writeByte;
+	encodeRun = 0;
+}
+
+
+
+/**
+* @brief	Add a run of samples to the recording
+*
+* @details	Bytes are only written when the level changes - so consecutive runs at the same level are joined.
+*			A run of 0 samples is ignored.  No run may be longer than RUNLENGTH_MAX_RUN samples in total.
+*
+* @param[in]	level		Level of the samples: 0 = Off; anything else = On
+* @param[in]	runLength	Number of samples
+*
+* @return	none
+************************************************************************/
+void RunLength_encodeRun(uint8_t level, uint32_t runLength)
+{
+	if (runLength == 0)
+	{
+		return;
+	}
+	
+	level = (level != 0);
+	
+	if (encodeRun == 0)
+	{
+		//First run: the recording starts with its level
+		encodeLevel = level;
+		encodeWriteByte(encodeLevel);
+	}
+	else if (level != encodeLevel)
+	{
+		//Level has changed: the run is complete
+		RunLength_writeRun(encodeRun);
+		encodeLevel = level;
+		encodeRun = 0;
+	}
+	
+	encodeRun += runLength;
+}
+
+
+
+/**
+* @brief	Finish encoding the recording
+*
+* @details	Writes the last run, and the end marker.
+*
+* @return	none
+************************************************************************/
+void RunLength_finishEncode(void)
+{
+	if (encodeRun > 0)
+	{
+		RunLength_writeRun(encodeRun);
+	}
+	else
+	{
+		encodeWriteByte(0);	//No samples: an empty recording, which replays as Off
+	}
+	
+	RunLength_writeRun(RUNLENGTH_END);
+}
+
+
+
+/**
+* @brief	Start decoding a recording
+*
+* @param[in]	readByte	Function returning the next encoded byte, looping back to the start of the
+*							recording after the end marker
+*
+* @return	none
+************************************************************************/
+void RunLength_startDecode(uint8_t (*readByte)(void))
+{
+	decodeReadByte = readByte;
+	
+	decodeLevel = (decodeReadByte() != 0);	//Recording starts with the first level
+	decodeRemaining = 0;
+	isFirstRun = 1;
+}
+
+
+
+/**
+* @brief	Read the next run from the recording, if the current run is finished
+*
+* @details	At the end marker, starts again from the beginning of the recording.
+*
+* @return	none
+************************************************************************/
+static void RunLength_nextRun(void)
+{
+	uint8_t endCount = 0;
+	uint32_t runLength;
+	
+	while (decodeRemaining == 0)
+	{
+		runLength = RunLength_readRun();
+		
+		if (runLength == RUNLENGTH_END)
+		{
+			//End of the recording: the start of the recording follows
+			decodeLevel = (decodeReadByte() != 0);
+			isFirstRun = 1;
+			
+			//Two end markers in a row means there's no recording - hold the level rather than loop forever
+			endCount++;
+			if (endCount > 1)
+			{
+				decodeRemaining = 1;
+			}
+		}
+		else
+		{
+			if (!isFirstRun)
+			{
+				decodeLevel = !decodeLevel;	//Level changes after every run
+			}
+			isFirstRun = 0;
+			decodeRemaining = runLength;
+		}
+	}
+}
+
+
+
+/**
+* @brief	Take the rest of the current run from the recording
+*
+* @details	Returns the whole of the next run.  Runs are at least one sample long.
+*
+* @param[out]	level	Level of the run: 0 = Off; 1 = On
+*
+* @return	Number of samples in the run
+************************************************************************/
+uint32_t RunLength_decodeRun(uint8_t *level)
+{
+	uint32_t runLength;
+	
+	RunLength_nextRun();
+	
+	runLength = decodeRemaining;
+	decodeRemaining = 0;
+	*level = decodeLevel;
+	
+	return runLength;
+}
@@ -0,0 +1,30 @@
+/*
+ * @file	RunLength.h
+ *
+ *  ------------------------------------
+ *  @author	Andrew Retallack, Crash-Bang Prototyping
+ *			www.crash-bang.com
+ *  @date	16/10/2026
+ *
+ */ 
+
+
+#ifndef RUNLENGTH_H_
+#define RUNLENGTH_H_
+
+#include <avr/io.h>
+
+#define RUNLENGTH_MAX_RUN_BYTES	4	//Most bytes used to encode one run (7 bits per byte)
+#define RUNLENGTH_MAX_RUN		0x0FFFFFFFUL	//Longest run that can be stored (28 bits)
+#define RUNLENGTH_END			0	//Run length marking the end of a recording
+
+
+void RunLength_startEncode(void (*writeByte)(uint8_t data));
+void RunLength_encodeRun(uint8_t level, uint32_t runLength);
+void RunLength_finishEncode(void);
+void RunLength_startDecode(uint8_t (*readByte)(void));
+uint32_t RunLength_decodeRun(uint8_t *level);
+
+
+
+#endif /* RUNLENGTH_H_ */
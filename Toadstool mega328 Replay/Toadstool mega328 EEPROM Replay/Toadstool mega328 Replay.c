@@ -5,8 +5,12 @@
  *  ========================================
  *  Mount the Toadstool 24LC EEPROM module onto the Toadstool Mega328 board
  *
- *  This application replays a sequence of LED flashes, at a sample rate of 100ms.
+ *  This application replays a sequence of LED flashes, with 1ms timing resolution.
  *  The sequence is stored on the EEPROM, and can be programmed by the user.
+ *  Switch edges are timestamped by Timer1's input capture, and the time between them is
+ *  stored - so storage depends on the number of presses rather than the length of the recording.
+ *  On replay, each edge is made by Timer1's compare output hardware, on the exact timer count.
+ *  Between interrupts the ATmega328P sleeps, and estimates its own current (see powerCurrentUA).
  *  
  *  1. To re-initialise the EEPROM to an 800ms on/off sequence, hold switch down
  *		while powering on the Toadstool.  
@@ -21,6 +25,16 @@
  *	- after power-on initialisation is complete (LED is lit for 3 seconds)
  *	- after EEPROM re-initialisation (1 above) is complete
  *	- after recording is complete
+ *
+ *  LOGIC RECORDER (REPLAY_MODE = REPLAY_MODE_LOGIC)
+ *	Instead of the switch, records the 8 pins of PORTD at 1kHz, and replays them onto the same pins.
+ *	Start recording with the switch as above; press the switch again to stop.  Holding the switch
+ *	down at power-on erases the recording.  See LogicRecorder.h for the port, channels and rate.
+ *
+ *  ANALOG RECORDER (REPLAY_MODE = REPLAY_MODE_ANALOG)
+ *	Instead of the switch, records the voltage on ADC0 (PC0) at about 500 samples/sec, and replays it
+ *	as a PWM output on PD5.  Start and stop recording with the switch as for the Logic Recorder.
+ *	See AnalogRecorder.h for the channel and rate.
  *    
  *  ------------------------------------
  *  @author	Andrew Retallack, Crash-Bang Prototyping 
@@ -32,6 +46,8 @@
  *  ===========
  *  Connect pushbutton between PB0 and GND
  *  Connect LED to PB1 (anode)
+ *  Logic Recorder: connect the signals to record / replay to PD0-PD7
+ *  Analog Recorder: connect the input to PC0 (0-5V), and an RC low-pass filter (eg. 10k / 100nF) to PD5 for the output
  *
  */ 
 
@@ -47,22 +63,63 @@
 /**********************************
 *  User-Defined Macros
 ***********************************/
-#define EEPROM_DEVICE_ADDRESS 0b10100110	//EEPROM's Device Address on the I2C bus.  Only 7 MSB bits used, LSB bit is always zero
-#define EEPROM_FIRST_ADDRESS 20		//First address for storing recorded data
-#define EEPROM_MAX_ADDRESS 15999	//Maximum address that can be written to the EEPROM (128kBit: 128,000 / 8)
+#define REPLAY_MODE_SWITCH	0	//Record the switch, and replay it on the LED
+#define REPLAY_MODE_LOGIC	1	//Record a whole port (8 channels), and replay it onto the same pins
+#define REPLAY_MODE_ANALOG	2	//Record an analog input, and replay it as a PWM output
+
+#ifndef REPLAY_MODE
+#define REPLAY_MODE	REPLAY_MODE_SWITCH
+#endif
+
+#define EEPROM_DEVICE_ADDRESS 0b10100110	//EEPROM's Device Address on the I2C bus.  Only 7 MSB bits used, LSB bit is always zero.
+											//The part fitted (and so its size) is set by EEPROM_PART - see EEPROM.h
+//First address for storing recorded data: the first page after the last address log.  The log is written directly,
+//so must never share a page with the recording, which is written through the page cache
+#define EEPROM_FIRST_ADDRESS (((EEPROM_LOG_END + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE) * EEPROM_PAGE_SIZE)
+
+//Logic and Analog Recorders: first address in the EEPROM volume, skipping the pages of each chip that hold the last address log
+#define VOLUME_FIRST_ADDRESS	((uint32_t)EEPROM_FIRST_ADDRESS * EEPROM_VOLUME_CHIPS)
+#define VOLUME_MAX_PAGES		(uint16_t)((EEPROM_VOLUME_CAPACITY - VOLUME_FIRST_ADDRESS) / EEPROM_PAGE_SIZE)	//Most pages in a logic or analog recording
+
+#ifndef REPLAY_SECS
+#define REPLAY_SECS				5		//Switch: maximum number of seconds to record.  The switch is being recorded, so can't stop the recording early
+#endif
+#define REPLAY_RESOLUTION_US	1000	//Timing resolution of the recording, in microseconds.  A multiple of 4us (one Timer1 count)
+#define REPLAY_MAX_ADDRESS		EEPROM_MAX_ADDRESS	//Last address available for the recording
+#define CONTROL_TICK_MS			100		//Interval for checking the switch and moving between states.  A multiple of LEDPATTERN_TICK_MS
+#define CAPTURE_RING_SIZE		16		//Number of edges that can wait to be recorded.  A power of 2, and no more than 128
+#define BUTTON_DEBOUNCE_MS		20		//Time the switch is left to stop bouncing after each press or release
+
+//Power instrumentation: the current is estimated from the time spent awake and asleep
+#ifndef POWER_ACTIVE_UA
+#define POWER_ACTIVE_UA			9500UL	//Typical current of the ATmega328P while awake, at 16MHz and 5V (from the datasheet)
+#endif
+#ifndef POWER_IDLE_UA
+#define POWER_IDLE_UA			2500UL	//Typical current of the ATmega328P in Idle sleep, at 16MHz and 5V, with unused peripherals off
+#endif
+#define POWER_WINDOW_MS			10000	//Interval over which the duty cycle and current are measured.  Well under the ~4.7 hours the time (getTime) takes to wrap
 
-#define REPLAY_SECS			5		//Number of seconds to record and replay
-#define REPLAY_SAMPLE_MS	100		//Number of milliseconds per sample
-#define REPLAY_COUNT		(uint16_t)(REPLAY_SECS * 1000 / REPLAY_SAMPLE_MS / 8)	//Number of samples being recorded/replayed
+#ifndef REPLAY_HARDWARE_OUTPUT
+#define REPLAY_HARDWARE_OUTPUT	1		//1 = Replay edges are made by Timer1's compare output on OC1A (PB1), exactly on time
+										//0 = Replay edges are made by the compare interrupt, so are delayed by interrupt latency
+#endif
 
-#define PIN_LED PB1			//Connect LED to PB1
-#define PIN_SWITCH PB0		//Connect SWITCH to PB0
+#define TIMER1_COUNTS_PER_MS	(F_CPU / 64 / 1000UL)	//Timer1 runs at F_CPU / 64: 250 counts (4us each) per ms at 16MHz
+#define REPLAY_RESOLUTION_COUNTS	(uint16_t)((REPLAY_RESOLUTION_US * TIMER1_COUNTS_PER_MS) / 1000UL)	//Timer1 counts per unit of the recording
+#define REPLAY_MAX_COUNTS		(REPLAY_SECS * 1000UL * TIMER1_COUNTS_PER_MS)	//Timer1 counts in the longest recording
+#define POWER_WINDOW_COUNTS		(POWER_WINDOW_MS * TIMER1_COUNTS_PER_MS)	//Timer1 counts per power measurement
+#define PATTERN_TICK_COUNTS		(uint16_t)(LEDPATTERN_TICK_MS * TIMER1_COUNTS_PER_MS)	//Timer1 counts per LED pattern tick.  No more than 262ms
+
+#define PIN_LED PB1			//Connect LED to PB1 (OC1A - Timer1's compare output A)
+#define PIN_SWITCH PB0		//Connect SWITCH to PB0 (ICP1 - Timer1's input capture pin)
 
 //Define the possible states
 #define STATE_REPLAY	0
 #define STATE_START_REC	1
 #define STATE_RECORDING	2
 #define STATE_STOP_REC	3
+#define STATE_BOOT		4
+#define STATE_START_REPLAY	5
 
 
 /**********************************
@@ -70,9 +127,35 @@
 ***********************************/
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <util/delay.h>
+#include <avr/sleep.h>
 #include "I2C.h"			//Simple library of I2C (TWI) routines
 #include "EEPROM.h"			//Simple library of EEPROM routines
+#include "EEPROMCache.h"	//Write-back page cache for recording to EEPROM
+#include "Prefetch.h"		//Read-ahead buffer for replaying from EEPROM
+#include "RunLength.h"		//Compressed recording format
+#include "RingBuffer.h"		//Lock-free buffer for passing edges from the capture interrupt
+#include "LogicRecorder.h"	//8-channel logic recorder mode
+#include "AnalogRecorder.h"	//Analog recorder mode
+#include "LEDPattern.h"		//LED flash patterns, shown without blocking
+#include "Button.h"			//Debounced switch events from the pin change interrupt
+
+#if (CONTROL_TICK_MS % LEDPATTERN_TICK_MS) != 0
+#error "CONTROL_TICK_MS must be a multiple of LEDPATTERN_TICK_MS"
+#endif
+
+#if BUTTON_PIN != PIN_SWITCH
+#error "BUTTON_PIN must be PIN_SWITCH"
+#endif
+
+
+/**********************************
+*  Types
+***********************************/
+typedef struct
+{
+	uint32_t time;	//Time of the edge, in Timer1 counts
+	uint8_t level;	//Level after the edge: 1 = Switch pressed
+} EdgeCapture;
 
 
 /**********************************
@@ -80,50 +163,109 @@
 ***********************************/
 void configPins(void);
 void configTimer(void);
-void flashLED(void);
+void configPower(void);
+void idle(void);
+void updatePowerStats(void);
+uint32_t getTime(void);
+uint32_t extendTime(uint16_t count);
+uint8_t isLEDFree(void);
 void clearMemory(void);
-void replay1Bit(void);
-void record1Bit(void);
+void replayStart(void);
+void replayStop(void);
+void replayService(void);
+void replaySetOutput(uint8_t level);
+void replaySetLED(uint8_t level);
+void recordStart(void);
+void recordStop(void);
+uint8_t recordService(void);
+void recordEdge(uint32_t edgeTime, uint8_t level);
+void recordByte(uint8_t data);
+void recorderStartRecord(void);
+uint8_t recorderServiceRecord(uint8_t isStopPressed);
+uint16_t recorderStopRecord(void);
+void recorderStartReplay(void);
+void recorderServiceReplay(void);
+void recorderStopReplay(void);
+uint16_t recorderClear(void);
+uint8_t recorderIsValid(uint16_t lastAddress);
+uint8_t recorderIsBusy(void);
 
 
 /**********************************
 *  Global Variables (for simplicity)
 ***********************************/
 volatile uint8_t currentState;	//Current State: replay / start record / recording / end record
-volatile uint16_t currentMemLocation;	//In replay/record state, the current EEPROM memory location
-volatile uint8_t currentMemBit;			//In replay/record state, the bit of the current EEPROM memory location
+volatile uint16_t currentMemLocation;	//In record state, the next EEPROM memory location to write to
 volatile uint8_t isrFlag;	//Flag Interrupt
-volatile uint8_t LEDValue;	//Byte containing 8 sequential LED values (1 per bit)
+uint8_t patternTicks;		//LED pattern ticks since the last control tick
+uint16_t replayLastAddress;	//Last address of the stored recording (its end marker).  Logic and Analog Recorders: number of pages recorded
+uint8_t isSwitchPressed;		//1 = The switch has been pressed since the state machine last ran
+
+volatile uint16_t timerOverflows;	//Number of Timer1 overflows: the high 16 bits of the time
+
+//Power instrumentation: read with the debugger.  Measured over each POWER_WINDOW_MS.
+//The interrupt that wakes the CPU runs before idle() reads the time again, so its time is counted as asleep:
+//both figures are a little low, by the run time of one interrupt per wake-up
+uint16_t powerDutyCycle;	//Time awake, in tenths of a percent (1000 = never asleep)
+uint16_t powerCurrentUA;	//Estimated average current of the ATmega328P, in uA (excludes the LED, EEPROM, etc.)
+uint32_t powerWindowStart;	//Time the measurement started, in Timer1 counts
+uint32_t powerSleepCounts;	//Time asleep since the measurement started, in Timer1 counts
+
+//Recording: the capture interrupt puts edges into captureRing, and the main loop records them.
+//captureRing.overflows counts any edges lost because the main loop fell behind
+EdgeCapture captureBuffer[CAPTURE_RING_SIZE];
+RingBuffer captureRing;
+uint32_t recordStartTime;	//Time the recording started, in Timer1 counts
+uint32_t recordLastUnit;	//Time of the last edge recorded, in units of the recording since recordStartTime
+uint8_t recordLevel;		//Level since the last edge recorded
+
+//Replay: the main loop schedules the next edge here, and the compare interrupt makes it happen on time
+volatile uint32_t replayEdgeTime;	//Time of the next edge, in Timer1 counts
+volatile uint8_t replayEdgeLevel;	//Level of the LED from the next edge
+volatile uint8_t isReplayScheduled;	//1 = Waiting for the next edge
+volatile uint8_t replayLevel;		//Level of the LED now
+volatile uint16_t replayMaxLatency;	//Longest delay from the compare match to the compare interrupt, in Timer1 counts (4us).
+									//Interrupt latency only: it doesn't show when the LED changed
+#if !REPLAY_HARDWARE_OUTPUT
+volatile uint16_t replayMaxEdgeDelay;	//Longest delay from the scheduled time of an edge to the LED changing, in Timer1 counts.
+										//With REPLAY_HARDWARE_OUTPUT the compare output changes the LED on the match itself, so
+										//there is no delay for software to measure - check the pin with a logic analyser
+#endif
+volatile uint16_t replayLateEdges;	//Edges that were scheduled after their time had passed
+uint32_t replayRunEnd;	//Time the current run ends, in Timer1 counts - the time of the edge after the scheduled one
+
+
+/**********************************
+*  LED Patterns (in flash)
+***********************************/
+#define PATTERN_FLASH	{1, LEDPATTERN_MS(150)}, {0, LEDPATTERN_MS(150)}	//One flash: on for 150ms, then off for 150ms
+
+const LEDPattern_step patternBoot[] PROGMEM = { {1, LEDPATTERN_MS(3000)}, {0, LEDPATTERN_HOLD} };	//On for 3 secs
+const LEDPattern_step patternStartRecord[] PROGMEM = { PATTERN_FLASH, PATTERN_FLASH, PATTERN_FLASH, {0, LEDPATTERN_HOLD} };
+const LEDPattern_step patternStopRecord[] PROGMEM = { PATTERN_FLASH, PATTERN_FLASH, PATTERN_FLASH, PATTERN_FLASH, PATTERN_FLASH, {0, LEDPATTERN_HOLD} };
+const LEDPattern_step patternClearMemory[] PROGMEM = { PATTERN_FLASH, PATTERN_FLASH, PATTERN_FLASH,	//3 flashes, on for a second, then 5 flashes
+	{1, LEDPATTERN_MS(1000)}, {0, LEDPATTERN_MS(150)}, PATTERN_FLASH, PATTERN_FLASH, PATTERN_FLASH, PATTERN_FLASH, PATTERN_FLASH, {0, LEDPATTERN_HOLD} };
 
 
 
 int main(void)
 {
+	ButtonEvent buttonEvent;
     
 	configPins();	//Configure the pins for input and output
 	
-	//Turn LED on for 3 secs to indicate initialisation, and allow time to press switch (and enter Memory Init)
-	PORTB |= (1<<PIN_LED);
-	_delay_ms(3000);
-	PORTB &= ~(1<<PIN_LED);
-
-	configTimer();	//Configure Timer to fire every 100ms
+	configPower();	//Turn off the peripherals that aren't used, and choose the sleep mode
 	
-	I2C_init(100);	//Initialise TWI(I2C) communication at 100kHz
+	configTimer();	//Configure Timer1 to run freely, with a pattern tick every 50ms and a control tick every 100ms
 	
-
-	currentState = STATE_REPLAY;	//Start in the Replay State
+	I2C_init();	//Initialise TWI(I2C) communication at I2C_SCL_HZ (400kHz)
 	
-	currentMemLocation = EEPROM_FIRST_ADDRESS;	//Start replaying from the first memory location
-	currentMemBit = 8;	//This forces a read as it is outside the allowed range of 0-7
+	Button_init(getTime, BUTTON_DEBOUNCE_MS * TIMER1_COUNTS_PER_MS);	//Time the switch's edges with Timer1
 	
-		
-	//Check whether button is pressed - if pressed, then pin will be LOW
-	//Holding button down during reset will re-initialise the EEPROM memory
-	if ((PINB & (1<<PIN_SWITCH)) == 0)
-	{
-		clearMemory();
-	}
+	//Turn LED on for 3 secs to indicate initialisation, and allow time to press switch (and enter Memory Init)
+	LEDPattern_start(patternBoot);
+	
+	currentState = STATE_BOOT;	//Start in the Boot State, then replay
 	
 	sei();	//Enable Interrupts so Timer interrupts fire
 	
@@ -131,49 +273,97 @@ int main(void)
 	while(1)
     {
         
-		//Has the timer interrupt fired?  If so, process
-		if (isrFlag == 1)
+		//Has the switch been pressed?  Act on it straight away, rather than on the next tick
+		Button_service();
+		isSwitchPressed = 0;
+		while (Button_getEvent(&buttonEvent))
+		{
+			if (buttonEvent.isPressed)
+			{
+				isSwitchPressed = 1;	//Releases aren't needed - switch mode records the switch by Input Capture
+			}
+		}
+		
+		//Between ticks, keep the replay or recording going
+		if (currentState == STATE_REPLAY)
+		{
+			recorderServiceReplay();
+		}
+		else if (currentState == STATE_RECORDING)
+		{
+			if (!recorderServiceRecord(isSwitchPressed))
+			{
+				currentState = STATE_STOP_REC;	//Full, run for long enough, or stopped by the switch
+			}
+		}
+		
+		//Has the timer interrupt fired, or the switch been pressed?  If so, process
+		if ((isrFlag == 1) || isSwitchPressed)
 		{
 			
 			isrFlag = 0;	//Reset ISR flag to off
 			
+			updatePowerStats();
+			
 			//Decide what to do based on current state
 			switch (currentState)
 			{
 				
+				//STATE: Power-on, waiting for the 3 second LED to finish
+				case STATE_BOOT:
+				
+					if (LEDPattern_isBusy())
+					{
+						break;
+					}
+					
+					//Find where the stored recording ends
+					replayLastAddress = EEPROM_getLastAddress(EEPROM_DEVICE_ADDRESS);
+					
+					//Check whether button is pressed.
+					//Holding button down during reset will re-initialise the EEPROM memory.
+					//Also initialise it if there is no recording yet
+					if (Button_isPressed() || !recorderIsValid(replayLastAddress))
+					{
+						clearMemory();
+					}
+					
+					currentState = STATE_START_REPLAY;	//Replay once the LED is free
+					
+					break;
+				
+				
 				//STATE: Replaying the recording
 				case STATE_REPLAY:
 				
-					//First check whether button pressed.  If so, need to enter recording state
-					if( (PINB & (1<<PIN_SWITCH)) == 0)
+					//Check whether button pressed.  If so, need to enter recording state
+					//(otherwise the replay carries on from the main loop and the compare interrupt)
+					if (isSwitchPressed)
 					{
+						recorderStopReplay();
+						
+						//Flash the LED 3 times so we know recording is about to start
+						LEDPattern_start(patternStartRecord);
+						
 						currentState = STATE_START_REC;
 					}
 					
-					//Otherwise, replay another bit from the recording (1 bit per 100ms)
 					else
 					{
-						replay1Bit();	
 						break;
 					}
+					//Fall through to start the recording, if the LED is already free
 				
 				
 				//STATE: Start the recording
 				case STATE_START_REC:	
-					//Flash the LED 3 times so we know recording is about to start
-					
-					TIMSK1 &= ~(1<<OCIE1A);	//Disable interrupts on Timer
-					
-					flashLED();
-					flashLED();
-					flashLED();
-					
-					TIMSK1 |= (1<<OCIE1A);	//Enable interrupts on Timer
-					
-					//Reset memory location and bit to first address
-					currentMemLocation = EEPROM_FIRST_ADDRESS;
-					currentMemBit = 0;
+				
+					if (!isLEDFree())
+					{
+						break;	//Wait for the flashes to finish
+					}
 					
+					recorderStartRecord();
 					
 					//Set state to recording
 					currentState = STATE_RECORDING;
@@ -183,28 +373,34 @@ int main(void)
 				
 				//STATE: Continue recording
 				case STATE_RECORDING:	
-					//We'll now record and store the value of the button (and therefore LED) every 100ms
-					record1Bit();
+					//The recording carries on from the main loop, which moves onto the "Stop Recording" state when it ends
 					break;
 					
 					
 				//STATE: Stop the recording
 				case STATE_STOP_REC:	
+				
+					replayLastAddress = recorderStopRecord();	//Write the rest of the recording to the EEPROM
+					
 					//Flash the LED 5 times so we know recording is finished
+					LEDPattern_start(patternStopRecord);
 					
-					TIMSK1 &= ~(1<<OCIE1A);	//Disable interrupts on Timer
+					//Only once the recording is written, log where it ends
+					EEPROM_setLastAddress(EEPROM_DEVICE_ADDRESS, replayLastAddress);
 					
-					flashLED();
-					flashLED();
-					flashLED();
-					flashLED();
-					flashLED();
+					currentState = STATE_START_REPLAY;
+					//Fall through to start the replay, if the LED is already free
 					
-					TIMSK1 |= (1<<OCIE1A);	//Enable interrupts on Timer
 					
-					//Reset memory location
-					currentMemLocation = EEPROM_FIRST_ADDRESS;
-					currentMemBit = 0;
+				//STATE: Start replaying the recording
+				case STATE_START_REPLAY:
+				
+					if (!isLEDFree())
+					{
+						break;	//Wait for the flashes to finish
+					}
+					
+					recorderStartReplay();
 					
 					currentState = STATE_REPLAY;	//Enter Replay mode
 				
@@ -213,6 +409,9 @@ int main(void)
 		
 		}
 		
+		//Sleep until the next interrupt - everything the main loop does is started by one
+		idle();
+		
 
     }
 	
@@ -245,20 +444,119 @@ void configPins(void)
 
 
 /**
-* @brief	Flash LED
+* @brief	Check whether the LED is free for the replay or recording
 *
-* @details	This function flashes the LED on and off for 150ms
+* @details	In switch mode the replay and the recording show on the LED, so they wait for an LED pattern
+*			to finish.  The Logic and Analog Recorders don't use the LED, so run alongside the pattern.
+*
+* @return	1 = LED free; 0 = LED pattern being shown
+************************************************************************/
+uint8_t isLEDFree(void)
+{
+#if REPLAY_MODE == REPLAY_MODE_SWITCH
+	return !LEDPattern_isBusy();
+#else
+	return 1;
+#endif
+}
+
+
+
+/**
+* @brief	Configure power saving
+*
+* @details	Turns off the peripherals the mode doesn't use, and selects Idle sleep - the deepest sleep
+*			that keeps Timer1 (the control tick and the replay), TWI and the pin change interrupt running.
 *
 * @return	none
 ************************************************************************/
-void flashLED(void)
+void configPower(void)
+{
+	ACSR |= (1<<ACD);	//Analog Comparator off
+	
+#if REPLAY_MODE == REPLAY_MODE_ANALOG
+	PRR = (1<<PRTIM2) | (1<<PRSPI) | (1<<PRUSART0);	//Timer0 (PWM output) and ADC used
+#elif REPLAY_MODE == REPLAY_MODE_LOGIC
+	PRR = (1<<PRTIM0) | (1<<PRSPI) | (1<<PRUSART0) | (1<<PRADC);	//Timer2 (sample clock) used
+#else
+	PRR = (1<<PRTIM2) | (1<<PRTIM0) | (1<<PRSPI) | (1<<PRUSART0) | (1<<PRADC);
+#endif
+	
+	set_sleep_mode(SLEEP_MODE_IDLE);
+}
+
 
+
+/**
+* @brief	Sleep until the next interrupt, unless there is work waiting
+*
+* @details	The check for work and going to sleep can't be separated by an interrupt: interrupts are
+*			disabled for the check, and only enabled by the instruction before SLEEP, so an interrupt
+*			that arrives after the check wakes the CPU straight away.
+*			The time asleep is added to powerSleepCounts.
+*
+* @return	none
+************************************************************************/
+void idle(void)
 {
+	uint32_t sleepStart;
+	
+	cli();
+	
+	if ((isrFlag == 1) || (RingBuffer_used(&buttonQueue) > 0))
+	{
+		sei();
+		return;	//State machine to run
+	}
+	
+	if (recorderIsBusy())
+	{
+		sei();
+		return;	//Replay or recording to keep going
+	}
+	
+	sleepStart = getTime();
+	
+	sleep_enable();
+	sei();
+	sleep_cpu();	//Executed before any interrupt waiting, so can't miss a wake-up
+	sleep_disable();
+	
+	powerSleepCounts += getTime() - sleepStart;	//Includes the waking interrupt (see powerDutyCycle)
+}
+
+
 
-	PORTB |= (1<<PIN_LED);		//Turn the LED on, by making pin go high
-	_delay_ms(150);
-	PORTB &= ~(1<<PIN_LED);		//Turn the LED off, by making pin go low
-	_delay_ms(150);
+/**
+* @brief	Update the power instrumentation
+*
+* @details	Call on each control tick.  Every POWER_WINDOW_MS, works out the duty cycle (time awake)
+*			and the average current from it, into powerDutyCycle and powerCurrentUA.
+*
+* @return	none
+************************************************************************/
+void updatePowerStats(void)
+{
+	uint32_t now = getTime();
+	uint32_t windowCounts = now - powerWindowStart;
+	uint32_t awakeCounts;
+	
+	if (windowCounts < POWER_WINDOW_COUNTS)
+	{
+		return;
+	}
+	
+	awakeCounts = windowCounts - powerSleepCounts;
+	powerDutyCycle = (uint16_t)(awakeCounts / (windowCounts / 1000));	//Tenths of a percent
+	if (powerDutyCycle > 1000)
+	{
+		powerDutyCycle = 1000;
+	}
+	
+	powerCurrentUA = (uint16_t)(((POWER_ACTIVE_UA * powerDutyCycle) + (POWER_IDLE_UA * (1000 - powerDutyCycle))) / 1000);
+	
+	powerWindowStart = now;
+	powerSleepCounts = 0;
 }
 
 
@@ -266,8 +564,11 @@ void flashLED(void)
 /**
 * @brief	Initialise the Timer
 *
-* @details	This function initialises Timer1 to trigger an interrupt when Compare occurs.
-*			Timer Interval = 100 msecs
+* @details	This function initialises Timer1 to run freely at F_CPU / 64 (4us per count at 16MHz).
+*			The overflow interrupt extends it to a 32-bit time (see getTime).
+*			Compare B triggers an interrupt every LEDPATTERN_TICK_MS (50ms) to move the LED pattern on,
+*			and every CONTROL_TICK_MS (100ms) to run the state machine.
+*			Compare A (replay) and Input Capture (recording) are enabled when needed.
 *
 * @return	none
 ************************************************************************/
@@ -277,193 +578,662 @@ void configTimer(void)
 	
 	//Order of setting registers as per data sheet
 	
-	TIMSK1 &= ~( (1<<OCIE1A) | (1<<OCIE1B) | (1<<TOIE1) );	//Disable interrupts on timer
+	TIMSK1 &= ~( (1<<ICIE1) | (1<<OCIE1A) | (1<<OCIE1B) | (1<<TOIE1) );	//Disable interrupts on timer
 	
-	TCCR1B = (1<<WGM12) | (1<<CS12) | (1<<CS10); //Set to CTC (compare) mode, set prescaler to 1024
+	TCCR1B = (1<<ICNC1) | (1<<CS11) | (1<<CS10); //Set to Normal mode, set prescaler to 64, filter the input capture
 	
-	TCCR1A = (0<<WGM11)|(0<<WGM10);		//Set to CTC (compare) mode
+	TCCR1A = (0<<WGM11)|(0<<WGM10);		//Set to Normal mode
 	
-	OCR1A = 1563;	// Crystal = 16MHz; Prescaler = 1024; cycles per sec = 15625; Interval = 100ms
+	OCR1B = TCNT1 + PATTERN_TICK_COUNTS;	// Crystal = 16MHz; Prescaler = 64; counts per ms = 250; Interval = 50ms
 
-	TIMSK1 |= (1<<OCIE1A);	//Enable interrupts on Compare
+	TIFR1 = (1<<ICF1) | (1<<OCF1A) | (1<<OCF1B) | (1<<TOV1);	//Clear any old interrupt flags
+	
+	TIMSK1 |= (1<<OCIE1B) | (1<<TOIE1);	//Enable interrupts on Compare B and Overflow
 	
 }
 
 
 
+/**
+* @brief	Extend a 16-bit Timer1 count to a 32-bit time
+*
+* @details	Adds the overflow count as the high 16 bits.  If the timer has overflowed since the count
+*			was taken but the overflow interrupt hasn't run yet, the overflow is counted here.
+*			Call with interrupts disabled, soon (less than half a timer period) after taking the count.
+*
+* @param[in]	count	The Timer1 count (TCNT1, ICR1, ...)
+*
+* @return	Time in Timer1 counts
+************************************************************************/
+uint32_t extendTime(uint16_t count)
+{
+	uint16_t overflows = timerOverflows;
+	
+	if ((TIFR1 & (1<<TOV1)) && (count < 0x8000))
+	{
+		overflows++;	//Overflow is pending, and the count was taken after it
+	}
+	
+	return ((uint32_t)overflows << 16) | count;
+}
+
+
+
+/**
+* @brief	Get the current time
+*
+* @details	Wraps around after 2^32 counts (about 4.7 hours) - compare times by subtracting them.
+*
+* @return	Time in Timer1 counts
+************************************************************************/
+uint32_t getTime(void)
+{
+	uint8_t savedSREG = SREG;
+	uint32_t now;
+	
+	cli();
+	now = extendTime(TCNT1);
+	SREG = savedSREG;	//Restore interrupts, if they were enabled
+	
+	return now;
+}
+
+
+
 /**
 * @brief	Re-initialise the EEPROM memory
 *
-* @details	Initialise the EEPROM memory to an 800ms on/off flash pattern
+* @details	Initialise the EEPROM memory to an 800ms on/off flash pattern.
+*			Logic and Analog Recorders: erase the recording
 *
 * @return	none
 ************************************************************************/
 void clearMemory(void)
 {
 	
-	uint8_t iCount;
+	//Three flashes to show memory being set, the LED on for a second, and five flashes to show finished.
+	//The memory is set while the pattern is shown - it takes much less than a second
+	LEDPattern_start(patternClearMemory);
 	
-	currentMemLocation = EEPROM_FIRST_ADDRESS;	//Start at the first memory address
+	replayLastAddress = recorderClear();
+	EEPROM_setLastAddress(EEPROM_DEVICE_ADDRESS, replayLastAddress);	//Log where the recording ends
+
+}
+
+
+
+/**********************************
+*  Recorder
+*
+*  The main loop and the state machine record and replay through these, whichever REPLAY_MODE is built:
+*	recorderStartRecord		Start recording
+*	recorderServiceRecord	Keep the recording going, from the main loop.  Returns 0 when the recording has to stop
+*	recorderStopRecord		Finish writing the recording.  Returns the replayLastAddress to log for it
+*	recorderStartReplay		Start replaying the recording described by replayLastAddress
+*	recorderServiceReplay	Keep the replay going, from the main loop
+*	recorderStopReplay		Stop replaying
+*	recorderClear			Replace the recording with the default one.  Returns its replayLastAddress
+*	recorderIsValid			Check that a replayLastAddress read from the log describes a recording
+*	recorderIsBusy			Check for replay or recording work waiting for the main loop.  Called with interrupts disabled
+***********************************/
+#if REPLAY_MODE != REPLAY_MODE_SWITCH
+
+//Logic and Analog Recorders: the recording is whole pages of the EEPROM volume, logged as the number of pages
+#if REPLAY_MODE == REPLAY_MODE_LOGIC
+#define RECORDER(function) LogicRecorder_##function
+#else
+#define RECORDER(function) AnalogRecorder_##function
+#endif
+
+void recorderStartRecord(void)
+{
+	RECORDER(startRecord)(VOLUME_FIRST_ADDRESS);	//Start sampling
+}
+
+uint8_t recorderServiceRecord(uint8_t isStopPressed)
+{
+	return RECORDER(serviceRecord)() && !isStopPressed;	//Write full pages to the EEPROM, until full or the switch is pressed
+}
+
+uint16_t recorderStopRecord(void)
+{
+	return RECORDER(stopRecord)();	//Write the last page
+}
+
+void recorderStartReplay(void)
+{
+	RECORDER(startReplay)(VOLUME_FIRST_ADDRESS, replayLastAddress);
+}
+
+void recorderServiceReplay(void)
+{
+	RECORDER(serviceReplay)();	//Keep the replay buffers full
+}
+
+void recorderStopReplay(void)
+{
+	RECORDER(stopReplay)();
+}
+
+uint16_t recorderClear(void)
+{
+	return 0;	//No pages
+}
+
+uint8_t recorderIsValid(uint16_t lastAddress)
+{
+	return (lastAddress <= VOLUME_MAX_PAGES);
+}
+
+uint8_t recorderIsBusy(void)
+{
+	return 0;	//The sample interrupts wake the main loop every sample
+}
+
+#else
+
+//Switch: the recording is run-length encoded from EEPROM_FIRST_ADDRESS, logged as the address of its end marker
+
+void recorderStartRecord(void)
+{
+	recordStart();	//Start capturing edges
+}
+
+uint8_t recorderServiceRecord(uint8_t isStopPressed)
+{
+	//Record any edge captured, until full or the recording has run for long enough.
+	//The switch is what is being recorded, so it doesn't stop the recording
+	return recordService() && ((getTime() - recordStartTime) < REPLAY_MAX_COUNTS);
+}
+
+uint16_t recorderStopRecord(void)
+{
+	recordStop();	//Record up to now, and write the end marker
 	
-	//Three flashes to show memory being set
-	flashLED();
-	flashLED();
-	flashLED();
+	EEPROMCache_flush();	//Write the recording to the EEPROM - one page write per page recorded
 	
-	//Leave the LED on during initialisation to show it is in progress
-	PORTB |= (1<<PIN_LED);
+	return currentMemLocation - 1;
+}
+
+void recorderStartReplay(void)
+{
+	Prefetch_start(EEPROM_DEVICE_ADDRESS, EEPROM_FIRST_ADDRESS, replayLastAddress);	//Read ahead the recording for replay
+	RunLength_startDecode(Prefetch_readByte);	//Replay the recording from the read-ahead buffer
+	replayStart();
+}
+
+void recorderServiceReplay(void)
+{
+	Prefetch_service();	//Top up the replay read-ahead buffer in the background
+	replayService();	//Schedule the next edge
+}
+
+void recorderStopReplay(void)
+{
+	replayStop();
+}
+
+uint16_t recorderClear(void)
+{
+	//The pattern is a single run of 800ms On and a run of 800ms Off, which the replay repeats
+	currentMemLocation = EEPROM_FIRST_ADDRESS;
+	RunLength_startEncode(recordByte);
+	RunLength_encodeRun(1, 800000UL / REPLAY_RESOLUTION_US);
+	RunLength_encodeRun(0, 800000UL / REPLAY_RESOLUTION_US);
+	RunLength_finishEncode();
 	
+	EEPROMCache_flush();
 	
+	return currentMemLocation - 1;
+}
 
-	//Loop through the number of memory locations used
-	//Why did we choose 800ms as an interval?  Because each bit represents 100ms, and 8 bits to a byte, so 8*100ms = 800ms
-	for (iCount=0; iCount <= (REPLAY_COUNT/2); iCount++)
+uint8_t recorderIsValid(uint16_t lastAddress)
+{
+	return (lastAddress >= EEPROM_FIRST_ADDRESS) && (lastAddress <= REPLAY_MAX_ADDRESS);
+}
+
+uint8_t recorderIsBusy(void)
+{
+	if ((currentState == STATE_REPLAY) && (!isReplayScheduled || !Prefetch_isIdle()))
 	{
-		//For the first 800ms, set the EEPROM to 1 (LED is ON)
-		EEPROM_write(EEPROM_DEVICE_ADDRESS, currentMemLocation, 0b11111111);
-		currentMemLocation++;
-		
-		//For the second 800ms, set the EEPROM to 0 (LED is OFF)
-		EEPROM_write(EEPROM_DEVICE_ADDRESS, currentMemLocation, 0b00000000);
-		currentMemLocation++;
+		return 1;	//Next edge to schedule, or read-ahead buffer to top up
 	}
 	
+	return (currentState == STATE_RECORDING) && (RingBuffer_used(&captureRing) > 0);	//Edges to record
+}
+
+#endif
+
+
+
+/**
+* @brief	Start replaying
+*
+* @details	The decoder must already be started (RunLength_startDecode).  The first edge is scheduled
+*			by replayService, one unit from now.
+*			With REPLAY_HARDWARE_OUTPUT, the LED pin is handed over to Timer1's compare output.
+*
+* @return	none
+************************************************************************/
+void replayStart(void)
+{
+	isReplayScheduled = 0;
+	replaySetLED(0);	//LED off until the first edge
+	replayRunEnd = getTime() + REPLAY_RESOLUTION_COUNTS;
+}
 
-	//Turn LED off
-	_delay_ms(1000);	//delay for UI reasons only
-	PORTB &= ~(1<<PIN_LED);
+
+
+/**
+* @brief	Stop replaying
+*
+* @details	Hands the LED pin back to PORTB, for the LED to be used directly.
+*
+* @return	none
+************************************************************************/
+void replayStop(void)
+{
+	TIMSK1 &= ~(1<<OCIE1A);	//No more edges
+	isReplayScheduled = 0;
 	
+#if REPLAY_HARDWARE_OUTPUT
+	TCCR1A &= ~((1<<COM1A1) | (1<<COM1A0));	//Disconnect the compare output: the pin follows PORTB again
+#endif
+}
+
+
+
+/**
+* @brief	Schedule the next replay edge
+*
+* @details	Once the last edge scheduled has happened, decode the next run from the recording, and set
+*			Compare A to change the LED at the start of the run.  The run is decoded while the previous
+*			run is playing, so the edge happens on time however long the decoding (or an EEPROM read) takes.
+*
+* @return	none
+************************************************************************/
+void replayService(void)
+{
+	uint8_t level;
+	uint32_t runLength;
+	uint32_t edgeTime;
+	uint32_t now;
 	
-	//Five flashes to show finished
-	flashLED();
-	flashLED();
-	flashLED();
-	flashLED();
-	flashLED();
+	if (isReplayScheduled)
+	{
+		return;	//Still waiting for the last edge
+	}
 	
+	edgeTime = replayRunEnd;
+	runLength = RunLength_decodeRun(&level);
+	replayRunEnd += runLength * REPLAY_RESOLUTION_COUNTS;
 	
-	//Reset memory location 
-	currentMemLocation = EEPROM_FIRST_ADDRESS;
-	currentMemBit = 8;	//This forces a read as it is outside the allowed range of 0-7
-
+	cli();
+	
+	replayEdgeTime = edgeTime;
+	replayEdgeLevel = level;
+	
+	now = getTime();
+	
+	if ((int32_t)(now - edgeTime) >= 0)
+	{
+		//Already late: change the LED now, without arming Compare A.  The lower 16 bits of a late edge
+		//can still be ahead of TCNT1, and that match would be taken as the edge without changing the LED
+		replaySetLED(level);
+		replayLateEdges++;
+		
+		sei();
+		return;
+	}
+	
+#if REPLAY_HARDWARE_OUTPUT
+	//Compare A matches every 2^16 counts.  Only set the output to change on the match that is the edge - 
+	//matches before that just set the LED to the level it already has (see the Compare A interrupt).
+	//Set before OCR1A, so any match from here on changes the LED
+	if ((edgeTime - now) < 0x10000UL)
+	{
+		replaySetOutput(level);
+	}
+	else
+	{
+		replaySetOutput(replayLevel);
+	}
+#endif
+	
+	TIFR1 = (1<<OCF1A);	//Clear any old match
+	OCR1A = (uint16_t)edgeTime;
+	
+	if (((int32_t)(getTime() - edgeTime) >= 0) && !(TIFR1 & (1<<OCF1A)))
+	{
+		//Passed while Compare A was being set, without a match: change the LED now.
+		//The edge was under 2^16 counts away, so a match here has changed the LED to the new level too
+		replaySetLED(level);
+		replayLateEdges++;
+	}
+	else
+	{
+		isReplayScheduled = 1;
+		TIMSK1 |= (1<<OCIE1A);	//Enable interrupts on Compare A
+	}
+	
+	sei();
 }
 
 
 
 /**
-* @brief	Replay one bit from EEPROM
+* @brief	Set what the compare output does on the next Compare A match
 *
-* @details	Replay the current bit from EEPROM, and read next byte from 
-*			EEPROM if needed.
+* @param[in]	level	1 = Set OC1A (LED on); 0 = Clear OC1A (LED off)
 *
 * @return	none
 ************************************************************************/
-void replay1Bit(void)
+void replaySetOutput(uint8_t level)
 {
+	if (level)
+	{
+		TCCR1A |= (1<<COM1A1) | (1<<COM1A0);	//Set OC1A on Compare Match
+	}
+	else
+	{
+		TCCR1A = (TCCR1A & ~(1<<COM1A0)) | (1<<COM1A1);	//Clear OC1A on Compare Match
+	}
+}
 
-	//Have we finished processing all bits for this Memory location's byte?
-	if (currentMemBit > 7)	//Yes: So read the next byte
+
+
+/**
+* @brief	Set the LED straight away during replay
+*
+* @param[in]	level	1 = LED on; 0 = LED off
+*
+* @return	none
+************************************************************************/
+void replaySetLED(uint8_t level)
+{
+#if REPLAY_HARDWARE_OUTPUT
+	replaySetOutput(level);
+	TCCR1C = (1<<FOC1A);	//Force a compare match: OC1A is set or cleared now
+#else
+	if (level)
 	{
-							
-		//Read the next byte from the current EEPROM memory location
-		LEDValue = EEPROM_read(EEPROM_DEVICE_ADDRESS, currentMemLocation);
-							
-		//Increment to the next memory location
-		currentMemLocation++;
-							
-		//If we've been going for more than the REPLAY Sample Count, then start from beginning
-		if (currentMemLocation > (REPLAY_COUNT + EEPROM_FIRST_ADDRESS))
-		currentMemLocation = EEPROM_FIRST_ADDRESS;
-							
-		//Start at bit 0 of current byte
-		currentMemBit = 0;
-							
+		PORTB |= (1<<PIN_LED);	//Turn LED on
 	}
-						
-	//Set the LED to current bit
-	if ( (LEDValue & (1<<currentMemBit)) == 0)	//If current bit is 0
+	else
 	{
 		PORTB &= ~(1<<PIN_LED);	//Turn LED off
 	}
+#endif
+	
+	replayLevel = level;
+}
+
+
+
+/**
+* @brief	Start recording
+*
+* @details	Notes the level of the switch, and enables Input Capture to timestamp its edges.
+*
+* @return	none
+************************************************************************/
+void recordStart(void)
+{
+	//Start recording at the first address
+	currentMemLocation = EEPROM_FIRST_ADDRESS;
+	RunLength_startEncode(recordByte);
+	
+	cli();
+	
+	recordStartTime = getTime();
+	recordLastUnit = 0;
+	recordLevel = ((PINB & (1<<PIN_SWITCH)) == 0);	//1 = Pressed
+	
+	//Show the switch on the LED, and capture the next edge: Rising (release) if pressed, otherwise Falling (press)
+	if (recordLevel)
+	{
+		PORTB |= (1<<PIN_LED);
+		TCCR1B |= (1<<ICES1);
+	}
 	else
 	{
-		PORTB |= (1<<PIN_LED);	//Turn LED on
+		PORTB &= ~(1<<PIN_LED);
+		TCCR1B &= ~(1<<ICES1);
 	}
-						
-	//Move onto next bit, for next time the timer interrupt fires
-	currentMemBit ++;
 	
+	RingBuffer_init(&captureRing, captureBuffer, sizeof(EdgeCapture), CAPTURE_RING_SIZE);
+	TIFR1 = (1<<ICF1);		//Clear the flag after changing the edge
+	TIMSK1 |= (1<<ICIE1);	//Enable interrupts on Input Capture
+	
+	sei();
 }
 
 
 
 /**
-* @brief	Record one bit
+* @brief	Stop recording
 *
-* @details	Record the current bit, and if the current byte is "full" 
-*			then write it to EEPROM
+* @details	Records the last edge captured, and the level up to now, then writes the end marker.
 *
 * @return	none
 ************************************************************************/
-void record1Bit(void)
+void recordStop(void)
 {
-	//If this is the first bit of this memory location, then then set entire byte to zero
-	if (currentMemBit == 0)
-		LEDValue = 0;
-					
-	//Is the switch pressed?
-	if( (PINB & (1<<PIN_SWITCH)) == 0)	//YES:
+	TIMSK1 &= ~(1<<ICIE1);	//No more edges
+	
+	recordService();
+	recordEdge(getTime(), recordLevel);	//The level since the last edge lasts until now
+	
+	RunLength_finishEncode();	//Write the last run and the end marker
+}
+
+
+
+/**
+* @brief	Record the edges captured
+*
+* @details	Takes all the edges waiting in captureRing, as a batch.  Stops capturing edges when there is
+*			only room left for one more edge, the last run and the end marker.
+*
+* @return	1 = Recording; 0 = Full, so the recording has to stop
+************************************************************************/
+uint8_t recordService(void)
+{
+	EdgeCapture *edges;
+	uint8_t edgeCount;
+	uint8_t iCount;
+	uint8_t isFull = 0;
+	
+	while ((edgeCount = RingBuffer_peek(&captureRing, (void **)&edges)) > 0)
+	{
+		for (iCount = 0; iCount < edgeCount; iCount++)
+		{
+			if (currentMemLocation > (REPLAY_MAX_ADDRESS - (3 * RUNLENGTH_MAX_RUN_BYTES)))
+			{
+				TIMSK1 &= ~(1<<ICIE1);	//Full: no more edges
+				isFull = 1;
+				break;
+			}
+			
+			recordEdge(edges[iCount].time, edges[iCount].level);
+		}
+		
+		RingBuffer_release(&captureRing, edgeCount);	//Edges not recorded once full are dropped
+	}
+	
+	return !isFull;
+}
+
+
+
+/**
+* @brief	Record an edge
+*
+* @details	The time since the last edge is rounded to units of the recording (REPLAY_RESOLUTION_US).
+*			Each edge's time is rounded on its own, so rounding errors don't add up over the recording.
+*			Pulses shorter than one unit may be lost.
+*
+* @param[in]	edgeTime	Time of the edge, in Timer1 counts
+* @param[in]	level		Level after the edge: 1 = Switch pressed
+*
+* @return	none
+************************************************************************/
+void recordEdge(uint32_t edgeTime, uint8_t level)
+{
+	uint32_t edgeUnit = (edgeTime - recordStartTime) / REPLAY_RESOLUTION_COUNTS;
+	
+	RunLength_encodeRun(recordLevel, edgeUnit - recordLastUnit);	//The level before the edge
+	
+	recordLastUnit = edgeUnit;
+	recordLevel = level;
+}
+
+
+
+/**
+* @brief	Write one byte of the compressed recording
+*
+* @details	Called by the run-length encoder.  Writes the byte to the current EEPROM memory location - 
+*			held in the page cache until the recording stops
+*
+* @param[in]	data	The encoded byte
+*
+* @return	none
+************************************************************************/
+void recordByte(uint8_t data)
+{
+	EEPROMCache_write(EEPROM_DEVICE_ADDRESS, currentMemLocation, data);
+	currentMemLocation++;
+}
+
+
+
+/**
+* @brief	Interrupt Handler for Timer1 Input Capture
+*
+* @details	Not called from user code.  Called on each switch edge, with the time of the edge in ICR1.
+*			The level is taken from the pin, and the next edge set from it - so a bounce that is over
+*			before the interrupt runs can't leave the edge detection out of step.
+*
+* @return	none
+************************************************************************/
+ISR(TIMER1_CAPT_vect)
+{
+	EdgeCapture edge;
+	
+	edge.time = extendTime(ICR1);
+	edge.level = ((PINB & (1<<PIN_SWITCH)) == 0);	//1 = Pressed
+	
+	//Capture the next edge: Rising (release) if pressed, otherwise Falling (press)
+	if (edge.level)
 	{
-		LEDValue |= (1<<currentMemBit);	//Set the value of this bit to a "1" so show switch was on
-		PORTB |= (1<<PIN_LED);			//Turn LED on to give feedback to user
+		PORTB |= (1<<PIN_LED);	//Show the switch on the LED
+		TCCR1B |= (1<<ICES1);
 	}
-	else  //NO:
+	else
 	{
-		//No need to set the value of the bit as the byte starts out as zero
-		PORTB &= ~(1<<PIN_LED);			//Turn LED off to give feedback to user
+		PORTB &= ~(1<<PIN_LED);
+		TCCR1B &= ~(1<<ICES1);
 	}
-					
+	TIFR1 = (1<<ICF1);	//Clear the flag after changing the edge
 	
-	currentMemBit++;	//Move to next bit
-					
-	//Have we finished recording all bits for this Memory Location?
-	if (currentMemBit > 7)	//Yes: So write the full byte
+	RingBuffer_put(&captureRing, &edge);	//If full, the edge is dropped and counted in captureRing.overflows
+}
+
+
+
+/**
+* @brief	Interrupt Handler for Timer1A Compare
+*
+* @details	Not called from user code.  Called by Timer1 Compare A, at the scheduled replay edge.
+*			Compare A matches every 2^16 counts, so only act on the match once the full 32-bit time
+*			has been reached.
+*			With REPLAY_HARDWARE_OUTPUT the compare output has already changed the LED - on the match
+*			before the edge, set the compare output up to change it on the next match.
+*			Otherwise, change the LED here.
+*
+* @return	none
+************************************************************************/
+ISR(TIMER1_COMPA_vect)
+{
+	uint16_t latency = TCNT1 - OCR1A;
+	uint32_t now = getTime();
+#if !REPLAY_HARDWARE_OUTPUT
+	uint16_t edgeDelay;
+#endif
+	
+	if (!isReplayScheduled)
 	{
-						
-		//Write the byte to the current EEPROM memory location
-		EEPROM_write(EEPROM_DEVICE_ADDRESS, currentMemLocation, LEDValue);
-						
-		//Increment to the next memory location
-		currentMemLocation++;
-						
-		//If we've been going for more than the REPLAY Sample Count, then end the recording
-		if (currentMemLocation > (REPLAY_COUNT + EEPROM_FIRST_ADDRESS))
+		return;
+	}
+	
+	if ((int32_t)(now - replayEdgeTime) >= 0)
+	{
+#if REPLAY_HARDWARE_OUTPUT
+		replayLevel = replayEdgeLevel;	//Compare output has changed the LED on the match
+#else
+		replaySetLED(replayEdgeLevel);
+		
+		edgeDelay = TCNT1 - OCR1A;	//Taken after the LED has changed
+		if (edgeDelay > replayMaxEdgeDelay)
 		{
-			currentState = STATE_STOP_REC;	//Move onto the "Stop Recording" state
+			replayMaxEdgeDelay = edgeDelay;
 		}
-		else
+#endif
+		
+		if (latency > replayMaxLatency)
 		{
-			//Start again at bit 0 of byte
-			currentMemBit = 0;
+			replayMaxLatency = latency;
 		}
-						
+		
+		isReplayScheduled = 0;
+		TIMSK1 &= ~(1<<OCIE1A);	//Wait for the main loop to schedule the next edge
 	}
-	
+#if REPLAY_HARDWARE_OUTPUT
+	else if ((replayEdgeTime - now) < 0x10000UL)
+	{
+		replaySetOutput(replayEdgeLevel);	//Next match is the edge
+	}
+#endif
 }
 
 
 
 /**
-* @brief	Interrupt Handler for Timer1A Compare
+* @brief	Interrupt Handler for Timer1B Compare
 *
-* @details	Not called from user code.  Called by Timer1 Compare interrupt.
+* @details	Not called from user code.  Called by Timer1 Compare B every LEDPATTERN_TICK_MS, to move
+*			the LED pattern on.  Flags the main loop every CONTROL_TICK_MS.
 *
 * @return	none
 ************************************************************************/
-ISR(TIMER1_COMPA_vect)
+ISR(TIMER1_COMPB_vect)
 {
 
-	//Set the flag to indicate Interrupt has fired
-	isrFlag = 1;
+	OCR1B += PATTERN_TICK_COUNTS;	//Next tick
+	
+	LEDPattern_tick();
+	
+	if (++patternTicks >= (CONTROL_TICK_MS / LEDPATTERN_TICK_MS))
+	{
+		patternTicks = 0;
+		
+		//Set the flag to indicate Interrupt has fired
+		isrFlag = 1;
+	}
+
+}
+
+
 
+/**
+* @brief	Interrupt Handler for Timer1 Overflow
+*
+* @details	Not called from user code.  Counts the high 16 bits of the time.
+*
+* @return	none
+************************************************************************/
+ISR(TIMER1_OVF_vect)
+{
+	timerOverflows++;
 }
\ No newline at end of file